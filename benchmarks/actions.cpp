@@ -0,0 +1,70 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "game/bounce_batch.hpp"
+#include "game/connect.hpp"
+
+#include "./benchmark.hpp"
+
+
+using namespace game;
+
+
+/*
+ * Listing and applying actions, through shared Action objects, or through
+ * lightweight move handles applied to an explicit state.
+ */
+
+
+template <typename Config, typename Generator>
+void run_game(char const* game, std::shared_ptr<Config> const& config, Generator& generator) {
+    using State = typename Config::State;
+    std::string suffix = std::string(" (") + game + ")";
+
+    // Both are measured on a fresh copy, where bounce recomputes the legal moves it stores
+    auto state = config->sample_initial_state();
+    auto copy = [&] {
+        auto result = std::make_shared<State>(*state);
+        if constexpr (requires { result->update_moves(); })
+            result->update_moves();
+        return result;
+    };
+    benchmark::run("copy" + suffix, [&] {
+        benchmark::keep(std::make_shared<State>(*state).get());
+    });
+    benchmark::run("copy, get_actions" + suffix, [&] {
+        benchmark::keep(copy()->get_actions().size());
+    });
+    benchmark::run("copy, get_moves" + suffix, [&] {
+        std::shared_ptr<State const> s = copy();
+        benchmark::keep(s->get_moves().size());
+    });
+
+    // Random playouts, which also include the cost of the game logic itself
+    benchmark::run("playout, actions" + suffix, [&] {
+        auto current = config->sample_initial_state();
+        for (int ply = 0; ply < 100 && !current->has_ended(); ++ply) {
+            auto actions = current->get_actions();
+            current = actions[generator() % actions.size()]->sample_next_state();
+        }
+        benchmark::keep(current->get_player());
+    });
+    benchmark::run("playout, moves" + suffix, [&] {
+        State current = *state;
+        for (int ply = 0; ply < 100 && !current.has_ended(); ++ply) {
+            auto moves = current.get_moves();
+            current.apply(moves[generator() % moves.size()]);
+        }
+        benchmark::keep(current.get_player());
+    });
+}
+
+
+int main() {
+    std::mt19937 generator(42);
+
+    run_game("connect 6x7", std::make_shared<connect::Config>(6, 7, 4), generator);
+    run_game("bounce 9x6", std::make_shared<bounce::Config>(bounce::sample_grid(9, 6, generator)), generator);
+}
@@ -0,0 +1,61 @@
+#ifndef GAME_BENCHMARK_HPP
+#define GAME_BENCHMARK_HPP
+
+
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+
+
+/*
+ * Minimal timing harness, to avoid depending on a benchmarking framework.
+ *
+ * Each benchmark is repeated until it runs for at least the given duration, and
+ * the average time per call is reported.
+ */
+
+
+namespace benchmark {
+
+
+// Prevent the compiler from optimizing away a computed value
+template <typename T>
+inline void keep(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+}
+
+
+template <typename F>
+double run(std::string_view name, F&& f, double min_seconds = 0.2) {
+    using clock = std::chrono::steady_clock;
+
+    // Warm up
+    f();
+
+    size_t iterations = 1;
+    double seconds = 0.0;
+    while (true) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            f();
+        seconds = std::chrono::duration<double>(clock::now() - start).count();
+        if (seconds >= min_seconds)
+            break;
+        iterations *= 2;
+    }
+
+    double nanoseconds = seconds * 1e9 / iterations;
+    std::printf("%-48.*s %12.2f ns/op %12zu iterations\n", int(name.size()), name.data(), nanoseconds, iterations);
+    return nanoseconds;
+}
+
+
+}
+
+
+#endif
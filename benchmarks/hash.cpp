@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "game/bounce_batch.hpp"
+#include "game/connect.hpp"
+#include "game/hash.hpp"
+
+#include "./benchmark.hpp"
+
+
+using namespace game;
+
+
+/*
+ * Hashing throughput, and dispersion over distinct reachable states.
+ *
+ * States are collected from random playouts, and deduplicated by their exact
+ * content. For each hash function, we report:
+ *  - full-width collisions, which should be none;
+ *  - collisions on the low 32 bits, compared to the birthday bound n^2/2^33;
+ *  - bucket occupancy of a power-of-two table (indexed by the low bits, as in
+ *    transposition_table), with one to two states per bucket; a uniform hash
+ *    leaves e^-load of the buckets empty, and has a normalized chi-square
+ *    close to 1.
+ *
+ * Usage: bench_hash [connect states] [bounce states]
+ */
+
+
+// The previous per-element FNV-1a path, as a baseline
+template <typename State>
+size_t hash_fnv(State const& state) {
+    size_t seed = hash_basis;
+    for (size_t i = 0; i < state.board.grid.size(); ++i)
+        hash_combine(seed, state.board.grid.data()[i]);
+    return hash_many(seed, state.player);
+}
+
+
+template <typename State>
+std::string get_content(State const& state) {
+    std::string content(reinterpret_cast<char const*>(state.board.grid.data()), state.board.grid.size());
+    content.push_back(char(state.player));
+    return content;
+}
+
+
+template <typename State, typename Generator>
+std::vector<std::shared_ptr<State>> collect_states(std::shared_ptr<typename State::Config> const& config, size_t count, size_t max_plies, Generator& generator) {
+    std::vector<std::shared_ptr<State>> states;
+    std::unordered_set<std::string> seen;
+    size_t stale = 0;
+    while (states.size() < count && stale < 1000) {
+        auto state = config->sample_initial_state();
+        size_t before = states.size();
+        for (size_t ply = 0; ply < max_plies; ++ply) {
+            if (seen.insert(get_content(*state)).second)
+                states.push_back(state);
+            if (states.size() >= count || state->has_ended())
+                break;
+            auto actions = state->get_actions();
+            std::uniform_int_distribution<size_t> distribution(0, actions.size() - 1);
+            state = actions[distribution(generator)]->sample_next_state();
+        }
+        stale = states.size() > before ? 0 : stale + 1;
+    }
+    return states;
+}
+
+
+void report(char const* name, std::vector<uint64_t> hashes) {
+    size_t n = hashes.size();
+
+    std::sort(hashes.begin(), hashes.end());
+    size_t full = 0;
+    for (size_t i = 1; i < n; ++i)
+        full += hashes[i] == hashes[i - 1];
+
+    std::vector<uint32_t> low(n);
+    for (size_t i = 0; i < n; ++i)
+        low[i] = uint32_t(hashes[i]);
+    std::sort(low.begin(), low.end());
+    size_t partial = 0;
+    for (size_t i = 1; i < n; ++i)
+        partial += low[i] == low[i - 1];
+    double expected = double(n) * double(n) / std::ldexp(1.0, 33);
+
+    size_t buckets = std::bit_floor(n);
+    std::vector<uint32_t> loads(buckets);
+    for (uint64_t h : hashes)
+        ++loads[h & (buckets - 1)];
+    double mean = double(n) / buckets;
+    double chi2 = 0.0;
+    size_t empty = 0;
+    uint32_t max_load = 0;
+    for (uint32_t load : loads) {
+        chi2 += (load - mean) * (load - mean) / mean;
+        empty += load == 0;
+        max_load = std::max(max_load, load);
+    }
+
+    std::printf(
+        "%-24s %10zu full %8zu low32 (expected %8.1f)  buckets %8zu  empty %6.4f (expected %6.4f)  max %3u  chi2/df %6.3f\n",
+        name, full, partial, expected, buckets, double(empty) / buckets, std::exp(-mean), max_load, chi2 / (buckets - 1)
+    );
+}
+
+
+template <typename State>
+void run_state(char const* game, std::vector<std::shared_ptr<State>> const& states) {
+    std::printf("\n%s: %zu distinct states\n", game, states.size());
+
+    std::vector<uint64_t> hashes(states.size());
+    for (size_t i = 0; i < states.size(); ++i)
+        hashes[i] = hash_value(*states[i]);
+    report("hash_value", hashes);
+    for (size_t i = 0; i < states.size(); ++i)
+        hashes[i] = hash_fnv(*states[i]);
+    report("FNV-1a per element", hashes);
+
+    // Throughput, on a state picked at random, with the memoized hash discarded
+    State& state = *states[states.size() / 2];
+    std::string suffix = std::string(" (") + game + ")";
+    benchmark::run("hash_value(state), uncached" + suffix, [&] {
+        state.cached_hash.reset();
+        benchmark::keep(hash_value(state));
+    });
+    benchmark::run("hash_value(state), cached" + suffix, [&] {
+        benchmark::keep(hash_value(state));
+    });
+    benchmark::run("FNV-1a per element" + suffix, [&] {
+        benchmark::keep(hash_fnv(state));
+    });
+
+    // Equality of distinct objects with equal content, the worst case in hash tables
+    State copy = state;
+    benchmark::run("operator==(state), equal" + suffix, [&] {
+        benchmark::keep(state == copy);
+    });
+    benchmark::run("identity tuple ==, equal" + suffix, [&] {
+        benchmark::keep(state.get_identity_tuple() == copy.get_identity_tuple());
+    });
+
+    // Probing a chain, where most candidates differ (here, only in the last cell)
+    State other = state;
+    other.board.grid.data()[other.board.grid.size() - 1] ^= 1;
+    other.cached_hash.reset();
+    hash_value(other);
+    benchmark::run("operator==(state), different" + suffix, [&] {
+        benchmark::keep(state == other);
+    });
+    benchmark::run("identity tuple ==, different" + suffix, [&] {
+        benchmark::keep(state.get_identity_tuple() == other.get_identity_tuple());
+    });
+}
+
+
+int main(int argc, char** argv) {
+    size_t connect_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    size_t bounce_count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    std::mt19937 generator(42);
+
+    // Throughput of building blocks
+    tensor<int8_t, 6, 7> grid;
+    grid.fill(-1);
+    grid[0][3] = 0;
+    grid[1][3] = 1;
+    benchmark::run("hash_value(tensor<int8_t, 6, 7>)", [&] {
+        benchmark::keep(hash_value(grid));
+    });
+    tensor<int8_t, -1, -1> dynamic_grid(9, 6);
+    dynamic_grid.fill(2);
+    benchmark::run("hash_value(tensor<int8_t, -1, -1>) 9x6", [&] {
+        benchmark::keep(hash_value(dynamic_grid));
+    });
+    tensor<float, 2> reward = { 1.0f, -1.0f };
+    benchmark::run("hash_value(tensor<float, 2>)", [&] {
+        benchmark::keep(hash_value(reward));
+    });
+    std::tuple<int, int, int> tuple = { 6, 7, 4 };
+    benchmark::run("hash_value(std::tuple<int, int, int>)", [&] {
+        benchmark::keep(hash_value(tuple));
+    });
+
+    auto connect_config = std::make_shared<connect::Config>(6, 7, 4);
+    run_state("connect 6x7", collect_states<connect::State>(connect_config, connect_count, 42, generator));
+
+    auto bounce_config = std::make_shared<bounce::Config>(bounce::sample_grid(9, 6, generator));
+    run_state("bounce 9x6", collect_states<bounce::State>(bounce_config, bounce_count, 200, generator));
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "game/simd.hpp"
+#include "game/tensor.hpp"
+
+#include "./benchmark.hpp"
+
+
+using namespace game;
+
+
+template <typename T>
+void run_kernels(char const* type, dim_t height, dim_t width) {
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 3);
+
+    tensor<T, -1, -1> a(height, width);
+    for (size_t i = 0; i < a.size(); ++i)
+        a.data()[i] = T(distribution(generator));
+    tensor<T, -1, -1> b = a;
+
+    // Worst case for comparison, as only the last element differs
+    b.data()[b.size() - 1] += 1;
+
+    std::string suffix = std::string(type) + " " + std::to_string(height) + "x" + std::to_string(width);
+    size_t size = a.size();
+
+    benchmark::run("std::equal " + suffix, [&] {
+        benchmark::keep(std::equal(a.data(), a.data() + size, b.data()));
+    });
+    benchmark::run("simd::equal " + suffix, [&] {
+        benchmark::keep(simd::equal(a.data(), b.data(), size));
+    });
+
+    benchmark::run("std::lexicographical_compare_three_way " + suffix, [&] {
+        auto c = std::lexicographical_compare_three_way(a.data(), a.data() + size, b.data(), b.data() + size);
+        benchmark::keep(c < 0);
+    });
+    benchmark::run("simd::compare_three_way " + suffix, [&] {
+        auto c = simd::compare_three_way(a.data(), size, b.data(), size);
+        benchmark::keep(c < 0);
+    });
+
+    benchmark::run("std::fill_n " + suffix, [&] {
+        std::fill_n(a.data(), size, T(0));
+        benchmark::keep(a.data()[0]);
+    });
+    benchmark::run("simd::fill " + suffix, [&] {
+        simd::fill(a.data(), size, T(0));
+        benchmark::keep(a.data()[0]);
+    });
+
+    benchmark::run("hash " + suffix, [&] {
+        benchmark::keep(hash_value(b));
+    });
+}
+
+
+int main() {
+
+#if defined(__AVX2__)
+    std::printf("SIMD: AVX2 (compile-time)\n");
+#elif defined(GAME_SIMD_AVX2_RUNTIME)
+    std::printf("SIMD: %s (runtime)\n", simd::has_avx2() ? "AVX2" : "SSE2");
+#elif defined(GAME_SIMD_SSE2)
+    std::printf("SIMD: SSE2\n");
+#else
+    std::printf("SIMD: scalar\n");
+#endif
+
+    run_kernels<int8_t>("int8", 7, 6);
+    run_kernels<int8_t>("int8", 16, 16);
+    run_kernels<int8_t>("int8", 256, 256);
+    run_kernels<int>("int", 16, 16);
+    run_kernels<int>("int", 256, 256);
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "game/parallel.hpp"
+#include "game/transposition_table.hpp"
+
+#include "./benchmark.hpp"
+
+
+using namespace game;
+
+
+struct Payload {
+    int16_t depth;
+    int16_t flags;
+    int32_t score;
+};
+
+
+// Random keys, as produced by a good hash
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+
+// Throughput of a mixed workload (one insertion every four probes), with each thread on its own key stream
+void run_threads(transposition_table<Payload>& table, unsigned num_threads, size_t operations) {
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    parallel_for(num_threads, num_threads, [&](size_t t) {
+        uint64_t found = 0;
+        for (size_t i = 0; i < operations; ++i) {
+            uint64_t key = mix(t * operations + i / 4);
+            if (i % 4 == 0)
+                table.insert_hash(key, { int16_t(i % 16), 0, int32_t(i) });
+            else
+                found += table.find_hash(key).has_value();
+        }
+        benchmark::keep(found);
+    });
+    double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+    double total = double(num_threads) * operations;
+    std::printf("%2u threads %12.2f Mops/s %12.2f Mops/s/thread\n", num_threads, total / seconds * 1e-6, total / seconds * 1e-6 / num_threads);
+}
+
+
+int main() {
+
+    // Larger than caches, as in a real search
+    transposition_table<Payload> table(size_t(1) << 24);
+    std::printf("capacity: %zu entries, %zu MiB\n", table.capacity(), table.get_memory_usage() >> 20);
+
+    benchmark::run("find_hash (miss)", [&, i = uint64_t(0)]() mutable {
+        benchmark::keep(table.find_hash(mix(++i)).has_value());
+    });
+    benchmark::run("insert_hash", [&, i = uint64_t(0)]() mutable {
+        table.insert_hash(mix(++i), { 1, 0, 0 });
+    });
+
+    unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+        run_threads(table, num_threads, 4000000);
+}
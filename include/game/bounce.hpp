@@ -2,12 +2,20 @@
 #define GAME_BOUNCE_HPP
 
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <memory>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
 #include "./comparison.hpp"
+#include "./memory.hpp"
+#include "./small_vector.hpp"
 #include "./tensor.hpp"
 
 
@@ -46,6 +54,92 @@ struct Move {
         if (auto cmp = (target[0] <=> right.target[0]); cmp != 0) return cmp;
         return target[1] <=> right.target[1];
     }
+
+    constexpr bool operator==(Move const& right) const noexcept {
+        return source == right.source && target == right.target;
+    }
+};
+
+
+/*
+  Packed representation of a move, where cells are indexed in row-major order,
+  i.e. y * width + x. This restricts boards to at most 256 cells.
+
+  Given the number of cells, moves are also mapped to a dense index space of size
+  cells * cells, which is suitable for policy outputs.
+*/
+struct MoveId {
+    static constexpr int max_cells = 256;
+
+    uint8_t source;
+    uint8_t target;
+
+    static constexpr MoveId from_move(Move const& move, int width) {
+        return {
+            uint8_t(move.source[1] * width + move.source[0]),
+            uint8_t(move.target[1] * width + move.target[0])
+        };
+    }
+
+    static constexpr MoveId from_index(int index, int cells) {
+        return { uint8_t(index / cells), uint8_t(index % cells) };
+    }
+
+    constexpr Move to_move(int width) const {
+        return {
+            { source % width, source / width },
+            { target % width, target / width }
+        };
+    }
+
+    constexpr int to_index(int cells) const {
+        return source * cells + target;
+    }
+
+    constexpr auto operator<=>(MoveId const& right) const noexcept = default;
+};
+
+static_assert(sizeof(MoveId) == 2);
+
+
+/*
+  Immutable list of legal moves, shared among copies of a state. It owns its
+  storage, hence it remains valid after the state is modified or destroyed.
+  Empty lists do not allocate.
+*/
+class MoveList {
+public:
+
+    MoveList() = default;
+
+    explicit MoveList(std::vector<MoveId> ids) {
+        if (!ids.empty())
+            this->ids = std::make_shared<std::vector<MoveId> const>(std::move(ids));
+    }
+
+    MoveId const* begin() const {
+        return ids ? ids->data() : nullptr;
+    }
+
+    MoveId const* end() const {
+        return ids ? ids->data() + ids->size() : nullptr;
+    }
+
+    size_t size() const {
+        return ids ? ids->size() : 0;
+    }
+
+    bool empty() const {
+        return !ids;
+    }
+
+    MoveId operator[](size_t index) const {
+        return (*ids)[index];
+    }
+
+private:
+
+    std::shared_ptr<std::vector<MoveId> const> ids;
 };
 
 
@@ -56,12 +150,12 @@ struct Walk {
     Walk(Grid const& grid) : grid(grid), source() {}
 
     void collect(int x, int y, int dy) {
-        int value = grid[y][x];
+        int value = grid(y, x);
         if (value > 0) {
             source = Coordinate{ x, y };
-            grid[y][x] = 0;
+            grid(y, x) = 0;
             recurse(x, y, 0, dy, value);
-            grid[y][x] = value;
+            grid(y, x) = value;
         }
     }
 
@@ -80,7 +174,7 @@ private:
             if (y >= height - 1)
                 return;
 
-            int value = grid[y + 1][x];
+            int value = grid(y + 1, x);
 
             // Empty space
             if (value == 0) {
@@ -92,9 +186,9 @@ private:
 
             // Bounce
             else if (value > 0 && remaining == 1) {
-                grid[y + 1][x] = -1;
+                grid(y + 1, x) = -1;
                 recurse(x, y + 1, 0, dy, value);
-                grid[y + 1][x] = value;
+                grid(y + 1, x) = value;
             }
         }
 
@@ -105,7 +199,7 @@ private:
             if (y == 0)
                 return;
 
-            int value = grid[y - 1][x];
+            int value = grid(y - 1, x);
 
             // Empty space
             if (value == 0) {
@@ -117,15 +211,15 @@ private:
 
             // Bounce
             else if (value > 0 && remaining == 1) {
-                grid[y - 1][x] = -1;
+                grid(y - 1, x) = -1;
                 recurse(x, y - 1, 0, dy, value);
-                grid[y - 1][x] = value;
+                grid(y - 1, x) = value;
             }
         }
 
         // Left
         if (x > 0 && dx <= 0) {
-            int value = grid[y][x - 1];
+            int value = grid(y, x - 1);
 
             // Empty space
             if (value == 0) {
@@ -137,15 +231,15 @@ private:
 
             // Bounce
             else if (value > 0 && remaining == 1) {
-                grid[y][x - 1] = -1;
+                grid(y, x - 1) = -1;
                 recurse(x - 1, y, 0, dy, value);
-                grid[y][x - 1] = value;
+                grid(y, x - 1) = value;
             }
         }
 
         // Right
         if (x < width - 1 && dx >= 0) {
-            int value = grid[y][x + 1];
+            int value = grid(y, x + 1);
 
             // Empty space
             if (value == 0) {
@@ -157,9 +251,9 @@ private:
 
             // Bounce
             else if (value > 0 && remaining == 1) {
-                grid[y][x + 1] = -1;
+                grid(y, x + 1) = -1;
                 recurse(x + 1, y, 0, dy, value);
-                grid[y][x + 1] = value;
+                grid(y, x + 1) = value;
             }
         }
     }
@@ -172,10 +266,248 @@ private:
 };
 
 
+/*
+  Alternative to Walk, where occupancy and piece values are stored as bitboards,
+  and paths are expanded using an explicit stack. Cells are indexed in row-major
+  order, i.e. y * width + x, which restricts this walker to boards with at most
+  64 cells.
+
+  Instead of temporarily marking bounced pieces in the grid, each frame carries
+  the set of pieces bounced along its path. The source cell is considered empty.
+*/
+typedef uint64_t Bitboard;
+
+
+struct BitWalk {
+    static constexpr int max_cells = 64;
+
+    enum Direction { UP, DOWN, LEFT, RIGHT };
+
+    /*
+      Neighbor masks of each cell (zero outside the board), which only depend on
+      the shape of the board. They are built once per shape, and shared by all
+      walkers; these are never freed.
+    */
+    struct Geometry {
+        std::array<std::array<Bitboard, 4>, max_cells> neighbors;
+
+        Geometry(int height, int width) : neighbors{} {
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x) {
+                    int cell = y * width + x;
+                    neighbors[cell][UP] = y < height - 1 ? Bitboard(1) << (cell + width) : 0;
+                    neighbors[cell][DOWN] = y > 0 ? Bitboard(1) << (cell - width) : 0;
+                    neighbors[cell][LEFT] = x > 0 ? Bitboard(1) << (cell - 1) : 0;
+                    neighbors[cell][RIGHT] = x < width - 1 ? Bitboard(1) << (cell + 1) : 0;
+                }
+        }
+
+        static Geometry const& get(int height, int width) {
+            static std::array<std::atomic<Geometry const*>, (max_cells + 1) * (max_cells + 1)> cache = {};
+            auto& slot = cache[height * (max_cells + 1) + width];
+            Geometry const* geometry = slot.load(std::memory_order_acquire);
+            if (!geometry) {
+                Geometry const* created = new Geometry(height, width);
+                if (slot.compare_exchange_strong(geometry, created, std::memory_order_acq_rel))
+                    geometry = created;
+                else
+                    delete created;
+            }
+            return *geometry;
+        }
+    };
+
+    int width;
+    int height;
+    Bitboard occupied;
+    std::array<Bitboard, 3> values;
+
+    // Negative cells, which block moves like pieces, but cannot be bounced on (as in Walk)
+    Bitboard walls;
+
+    Geometry const* geometry;
+    std::set<Move> moves;
+
+    static constexpr bool supports(int height, int width) {
+        return height >= 1 && width >= 1 && height * width <= max_cells;
+    }
+
+    static constexpr bool supports(Grid const& grid) {
+        return supports(grid.shape()[0], grid.shape()[1]);
+    }
+
+    BitWalk(int height, int width) :
+        width(width),
+        height(height),
+        occupied(0),
+        values{},
+        walls(0),
+        geometry(nullptr)
+    {
+        if (!supports(height, width))
+            throw std::runtime_error("grid is too large");
+        geometry = &Geometry::get(height, width);
+    }
+
+    BitWalk(Grid const& grid) : BitWalk(grid.shape()[0], grid.shape()[1]) {
+        load(grid.as_view());
+    }
+
+    void load(view<int8_t const, -1, -1> grid) {
+        if (grid.shape()[0] != height || grid.shape()[1] != width)
+            throw shape_error();
+        occupied = 0;
+        values = {};
+        walls = 0;
+        for (int cell = 0; cell < height * width; ++cell) {
+            int value = grid.data()[cell];
+            if (value > 3)
+                throw std::runtime_error("invalid piece value");
+            if (value < 0)
+                walls |= Bitboard(1) << cell;
+            if (value > 0) {
+                occupied |= Bitboard(1) << cell;
+                values[value - 1] |= Bitboard(1) << cell;
+            }
+        }
+    }
+
+    // Move a piece, without any check
+    constexpr void apply(int source, int target) {
+        if (source == target)
+            return;
+        Bitboard source_mask = Bitboard(1) << source;
+        Bitboard target_mask = Bitboard(1) << target;
+        for (Bitboard& mask : values)
+            if (mask & source_mask)
+                mask ^= source_mask | target_mask;
+        occupied ^= source_mask | target_mask;
+    }
+
+    // Lowest (resp. highest) non-empty row for player 0 (resp. 1)
+    constexpr int get_row(int player) const {
+        if (!occupied)
+            return -1;
+        switch (player) {
+        case 0:
+            return std::countr_zero(occupied) / width;
+        case 1:
+            return (63 - std::countl_zero(occupied)) / width;
+        default:
+            return -1;
+        }
+    }
+
+    constexpr int get_value(int cell) const {
+        Bitboard mask = Bitboard(1) << cell;
+        if (values[0] & mask)
+            return 1;
+        if (values[1] & mask)
+            return 2;
+        if (values[2] & mask)
+            return 3;
+        return 0;
+    }
+
+    Bitboard get_targets(int source, int dy) const {
+        Bitboard targets = 0;
+        int value = get_value(source);
+        if (value == 0)
+            return targets;
+
+        Bitboard source_mask = Bitboard(1) << source;
+        Bitboard blocked = (occupied | walls) & ~source_mask;
+        int forward = dy > 0 ? UP : DOWN;
+
+        Stack stack;
+        stack.push({ int8_t(source), 0, int8_t(value), walls });
+        while (stack.size > 0) {
+            Frame frame = stack.pop();
+            auto const& neighbor = geometry->neighbors[frame.cell];
+
+            // Last row reached
+            if (!neighbor[forward])
+                continue;
+
+            step(stack, frame, neighbor[forward], 0, blocked, targets);
+            if (frame.dx <= 0 && neighbor[LEFT])
+                step(stack, frame, neighbor[LEFT], -1, blocked, targets);
+            if (frame.dx >= 0 && neighbor[RIGHT])
+                step(stack, frame, neighbor[RIGHT], 1, blocked, targets);
+        }
+        return targets;
+    }
+
+    void collect(int x, int y, int dy) {
+        Bitboard targets = get_targets(y * width + x, dy);
+        while (targets) {
+            int cell = std::countr_zero(targets);
+            targets &= targets - 1;
+            Coordinate source = { x, y };
+            Coordinate target = { cell % width, cell / width };
+            moves.insert({ source, target });
+        }
+    }
+
+private:
+
+    struct Frame {
+        int8_t cell;
+        int8_t dx;
+        int8_t remaining;
+        Bitboard bounced;
+    };
+
+    /*
+      A path has at most one segment per bounced piece, plus the initial one,
+      each of at most 3 steps. Each expanded frame leaves at most 2 pending
+      siblings, hence the stack is bounded by 3 frames per step.
+    */
+    struct Stack {
+        static constexpr int capacity = 3 * 3 * max_cells;
+
+        std::array<Frame, capacity> frames;
+        int size = 0;
+
+        void push(Frame const& frame) {
+            frames[size++] = frame;
+        }
+
+        Frame pop() {
+            return frames[--size];
+        }
+    };
+
+    void step(Stack& stack, Frame const& frame, Bitboard mask, int dx, Bitboard blocked, Bitboard& targets) const {
+        int cell = std::countr_zero(mask);
+
+        // Empty space
+        if (!(blocked & mask)) {
+            if (frame.remaining == 1)
+                targets |= mask;
+            else
+                stack.push({ int8_t(cell), int8_t(dx), int8_t(frame.remaining - 1), frame.bounced });
+        }
+
+        // Bounce
+        else if (frame.remaining == 1 && !(frame.bounced & mask)) {
+            stack.push({ int8_t(cell), 0, int8_t(get_value(cell)), frame.bounced | mask });
+        }
+    }
+};
+
+
 struct Board {
     Grid grid;
 
-    constexpr Board(Grid grid) : grid(grid) {}
+    // Number of pieces in each row, kept in sync by apply; stored inline for usual heights
+    small_vector<int16_t, 16> row_counts;
+    int bottom_row;
+    int top_row;
+
+    Board(Grid const& grid) : grid(grid) {
+        count_rows();
+    }
 
     constexpr int get_height() const {
         return grid.shape()[0];
@@ -185,30 +517,43 @@ struct Board {
         return grid.shape()[1];
     }
 
-    constexpr bool is_row_empty(int row) const {
+    // Must be called whenever the grid is modified directly
+    void count_rows() {
         int height = get_height();
         int width = get_width();
-        if (row >= 0 && row < height)
+        row_counts.resize(height);
+        bottom_row = -1;
+        top_row = -1;
+        for (int row = 0; row < height; ++row) {
+            int count = 0;
             for (int column = 0; column < width; ++column)
-                if (grid[row][column] > 0)
-                    return false;
-        return true;
+                if (grid(row, column) > 0)
+                    ++count;
+            row_counts[row] = count;
+            if (count > 0) {
+                if (bottom_row < 0)
+                    bottom_row = row;
+                top_row = row;
+            }
+        }
+    }
+
+    int get_row_count(int row) const {
+        if (row >= 0 && row < get_height())
+            return row_counts[row];
+        return 0;
+    }
+
+    bool is_row_empty(int row) const {
+        return get_row_count(row) == 0;
     }
 
     constexpr int get_bottom_row() const {
-        int height = get_height();
-        for (int row = 0; row < height; ++row)
-            if (!is_row_empty(row))
-                return row;
-        return -1;
+        return bottom_row;
     }
 
     constexpr int get_top_row() const {
-        int height = get_height();
-        for (int row = height - 1; row >= 0; --row)
-            if (!is_row_empty(row))
-                return row;
-        return -1;
+        return top_row;
     }
 
     constexpr int get_row(int player) const {
@@ -233,36 +578,88 @@ struct Board {
         }
     }
 
-    std::set<Move> get_moves(int player) const {
+    template <typename W>
+    std::set<Move> collect_moves(int player) const {
         int width = get_width();
         int y = get_row(player);
         int dy = get_direction(player);
-        Walk walk(grid);
+        W walk(grid);
         if (y >= 0)
             for (int x = 0; x < width; ++x)
                 walk.collect(x, y, dy);
         return walk.moves;
     }
 
-    std::set<Move> get_moves_at(int player, Coordinate source) const {
+    template <typename W>
+    std::set<Move> collect_moves_at(int player, Coordinate source) const {
         int width = get_width();
         int x = source[0];
         int y = source[1];
         int dy = get_direction(player);
-        Walk walk(grid);
+        W walk(grid);
         if (y == get_row(player) && x >= 0 && x < width)
             walk.collect(x, y, dy);
         return walk.moves;
     }
 
-    bool can_play(int player) const {
-        return !get_moves(player).empty();
+    std::set<Move> get_moves(int player) const {
+        if (BitWalk::supports(grid))
+            return collect_moves<BitWalk>(player);
+        return collect_moves<Walk>(player);
     }
 
-    constexpr void apply(Move const& move) {
-        int value = grid[move.source[1]][move.source[0]];
-        grid[move.source[1]][move.source[0]] = 0;
-        grid[move.target[1]][move.target[0]] = value;
+    std::set<Move> get_moves_at(int player, Coordinate source) const {
+        if (BitWalk::supports(grid))
+            return collect_moves_at<BitWalk>(player, source);
+        return collect_moves_at<Walk>(player, source);
+    }
+
+    // Legal moves, sorted by source and target cell indices
+    std::vector<MoveId> get_move_ids(int player) const {
+        std::vector<MoveId> result;
+        int width = get_width();
+        int y = get_row(player);
+        int dy = get_direction(player);
+        if (y < 0)
+            return result;
+        if (BitWalk::supports(grid)) {
+            BitWalk walk(grid);
+            for (int x = 0; x < width; ++x) {
+                int source = y * width + x;
+                for (Bitboard targets = walk.get_targets(source, dy); targets; targets &= targets - 1)
+                    result.push_back({ uint8_t(source), uint8_t(std::countr_zero(targets)) });
+            }
+        }
+        else {
+            for (Move const& move : collect_moves<Walk>(player))
+                result.push_back(MoveId::from_move(move, width));
+            std::sort(result.begin(), result.end());
+        }
+        return result;
+    }
+
+    bool can_play(int player) const {
+        return !get_move_ids(player).empty();
+    }
+
+    void apply(Move const& move) {
+        int value = grid(move.source[1], move.source[0]);
+        grid(move.source[1], move.source[0]) = 0;
+        grid(move.target[1], move.target[0]) = value;
+
+        // Update occupancy; the target row is never empty afterwards
+        int source_row = move.source[1];
+        int target_row = move.target[1];
+        --row_counts[source_row];
+        ++row_counts[target_row];
+        if (bottom_row < 0 || target_row < bottom_row)
+            bottom_row = target_row;
+        while (row_counts[bottom_row] == 0)
+            ++bottom_row;
+        if (target_row > top_row)
+            top_row = target_row;
+        while (row_counts[top_row] == 0)
+            --top_row;
     }
 };
 
@@ -283,6 +680,11 @@ struct Config : std::enable_shared_from_this<Config>, Comparable<Config> {
     Config(Grid const& grid) : board(grid) {
         if (board.get_bottom_row() == 0 || board.get_top_row() == board.get_height() - 1)
             throw std::runtime_error("bottom- and top-rows must be empty");
+        if (board.grid.size() > MoveId::max_cells)
+            throw std::runtime_error("grid is too large");
+        for (size_t i = 0; i < board.grid.size(); ++i)
+            if (board.grid.data()[i] < 0 || board.grid.data()[i] > 3)
+                throw std::runtime_error("piece values must be between 0 and 3");
         // TODO check a bit more?
     }
 
@@ -314,17 +716,28 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
     using Config = game::bounce::Config;
     using Action = game::bounce::Action;
 
+    // Bitboard representation, for in-place search on boards of at most 64 cells
+    using Position = BitWalk;
+
     std::shared_ptr<Config> config;
     Board board;
     int8_t player;
     int8_t winner;
 
+    // Hash of the identity, reset by apply
+    hash_cache cached_hash;
+
+    // Legal moves of the current player, updated eagerly, so that const methods only read them
+    MoveList moves;
+
     State(std::shared_ptr<Config> config) :
         config(config),
         board(config->board),
         player(0),
         winner(-1)
-    {}
+    {
+        update_moves();
+    }
 
     auto get_grid() const {
         return board.grid;
@@ -351,6 +764,31 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
 
     void apply(Action const& action);
 
+    /*
+      Lightweight alternative to Action, where moves are only identified by
+      their MoveId, as listed by get_moves, and validated against this state.
+    */
+    bool is_legal(MoveId id) const {
+        return std::binary_search(moves.begin(), moves.end(), id);
+    }
+
+    void apply(MoveId id) {
+        if (!is_legal(id))
+            throw std::runtime_error("invalid move");
+        apply_unchecked(id.to_move(board.get_width()));
+    }
+
+    void apply_unchecked(Move const& move);
+
+    MoveList get_moves() const {
+        return moves;
+    }
+
+    // Must be called after modifying the board or the player in place
+    void update_moves() {
+        moves = player >= 0 ? MoveList(board.get_move_ids(player)) : MoveList();
+    }
+
     std::vector<std::shared_ptr<Action>> get_actions();
     std::vector<std::shared_ptr<Action>> get_actions_at(Coordinate const& source);
     std::shared_ptr<Action> get_action_at(Coordinate const& source, Coordinate const& target);
@@ -359,6 +797,10 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
         return std::tie(board.grid, player);
     }
 
+    bool is_equal(State const& right) const {
+        return player == right.player && board.grid == right.board.grid;
+    }
+
     nlohmann::json to_json() const {
         return {
             { "grid", board.grid },
@@ -367,9 +809,11 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
     }
 
     static std::shared_ptr<State> from_json(nlohmann::json const& j, std::shared_ptr<Config> const& config) {
-        auto state = std::make_shared<State>(config);
+        auto state = game::allocate_shared<State>(config);
         j.at("grid").get_to(state->board.grid);
+        state->board.count_rows();
         j.at("player").get_to(state->player);
+        state->update_moves();
         // TODO set winner accordingly
         // TODO check player
         // TODO check that board matches configuration
@@ -379,7 +823,7 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
 
 
 std::shared_ptr<State> Config::sample_initial_state() {
-    return std::make_shared<State>(shared_from_this());
+    return game::allocate_shared<State>(shared_from_this());
 }
 
 
@@ -390,6 +834,9 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
     std::shared_ptr<State> state;
     Move move;
 
+    // Hash of the identity, which assumes that the state is not modified in place
+    hash_cache cached_hash;
+
     Action(std::shared_ptr<State> state, Move const& move) : state(state), move(move) {}
 
     Coordinate get_source() const {
@@ -400,8 +847,12 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
         return move.target;
     }
 
+    MoveId get_move_id() const {
+        return MoveId::from_move(move, state->board.get_width());
+    }
+
     std::shared_ptr<State> sample_next_state() const {
-        std::shared_ptr<State> next_state = std::make_shared<State>(*state);
+        std::shared_ptr<State> next_state = game::allocate_shared<State>(*state);
         next_state->apply(*this);
         return next_state;
     }
@@ -410,6 +861,10 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
         return std::tie(state->board.grid, state->player, move.source, move.target);
     }
 
+    bool is_equal(Action const& right) const {
+        return move == right.move && (state == right.state || *state == *right.state);
+    }
+
     nlohmann::json to_json() const {
         return {
             { "source", move.source },
@@ -421,7 +876,7 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
         Move move = {};
         j.at("source").get_to(move.source);
         j.at("target").get_to(move.target);
-        auto action = std::make_shared<Action>(state, move);
+        auto action = game::allocate_shared<Action>(state, move);
         // TODO check that move is valid
         return action;
     }
@@ -429,25 +884,33 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
 
 
 void State::apply(Action const& action) {
+    apply_unchecked(action.move);
+}
+
+
+void State::apply_unchecked(Move const& move) {
 
     // Move piece
-    board.apply(action.move);
+    board.apply(move);
+    cached_hash.reset();
 
     // Check for victory
-    int y = action.move.target[1];
+    int y = move.target[1];
     if (y == 0 || y == board.get_height() - 1) {
         winner = player;
         player = -1;
+        moves = {};
         return;
     }
 
     // If next player cannot play, they lose
     // However, if the other cannot either, this is a draw
     player = player ? 0 : 1;
-    if (!board.can_play(player)) {
-        player = player ? 0 : 1;
-        if (board.can_play(player))
-            winner = player;
+    update_moves();
+    if (moves.empty()) {
+        int other = player ? 0 : 1;
+        if (board.can_play(other))
+            winner = other;
         player = -1;
     }
 }
@@ -455,28 +918,90 @@ void State::apply(Action const& action) {
 
 std::vector<std::shared_ptr<Action>> State::get_actions() {
     std::vector<std::shared_ptr<Action>> result;
-    if (player >= 0)
-        for (Move const& move : board.get_moves(player))
-            result.push_back(std::make_shared<Action>(shared_from_this(), move));
+    int width = board.get_width();
+    for (MoveId id : moves)
+        result.push_back(game::allocate_shared<Action>(shared_from_this(), id.to_move(width)));
     return result;
 }
 
 
 std::vector<std::shared_ptr<Action>> State::get_actions_at(Coordinate const& source) {
     std::vector<std::shared_ptr<Action>> result;
-    if (player >= 0)
-        for (Move const& move : board.get_moves_at(player, source))
-            result.push_back(std::make_shared<Action>(shared_from_this(), move));
+    int width = board.get_width();
+    for (MoveId id : moves) {
+        Move move = id.to_move(width);
+        if (move.source == source)
+            result.push_back(game::allocate_shared<Action>(shared_from_this(), move));
+    }
     return result;
 }
 
 
 std::shared_ptr<Action> State::get_action_at(Coordinate const& source, Coordinate const& target) {
     Move move = { source, target };
-    std::set<Move> moves = board.get_moves_at(player, source);
-    if (!moves.contains(move))
+    int width = board.get_width();
+    int height = board.get_height();
+    if (source[0] < 0 || source[0] >= width || source[1] < 0 || source[1] >= height ||
+        target[0] < 0 || target[0] >= width || target[1] < 0 || target[1] >= height)
+        throw std::runtime_error("invalid move");
+    if (!is_legal(MoveId::from_move(move, width)))
         throw std::runtime_error("invalid move");
-    return std::make_shared<Action>(shared_from_this(), move);
+    return game::allocate_shared<Action>(shared_from_this(), move);
+}
+
+
+/*
+  Dense action space, where each pair of source and target cells is an action,
+  as defined by MoveId. This is meant to be used as a fixed-size policy output,
+  along with a mask of legal actions.
+*/
+
+inline int num_actions(Config const& config) {
+    int cells = config.board.grid.size();
+    return cells * cells;
+}
+
+inline int action_index(Action const& action) {
+    int width = action.state->board.get_width();
+    int cells = action.state->board.grid.size();
+    return MoveId::from_move(action.move, width).to_index(cells);
+}
+
+inline std::shared_ptr<Action> action_from_index(State& state, int index) {
+    int cells = state.board.grid.size();
+    if (index < 0 || index >= cells * cells)
+        throw std::runtime_error("invalid move");
+    Move move = MoveId::from_index(index, cells).to_move(state.board.get_width());
+    return state.get_action_at(move.source, move.target);
+}
+
+inline void legal_mask(State const& state, view<uint8_t, -1> mask) {
+    int cells = state.board.grid.size();
+    if (mask.size() != size_t(cells * cells))
+        throw shape_error();
+    mask.fill(0);
+    for (MoveId id : state.moves)
+        mask[id.to_index(cells)] = 1;
+}
+
+inline void legal_mask(std::span<State const* const> states, view<uint8_t, -1, -1> masks) {
+    if (masks.shape()[0] != (dim_t)states.size())
+        throw shape_error();
+    for (size_t i = 0; i < states.size(); ++i)
+        legal_mask(*states[i], masks[i]);
+}
+
+
+/*
+ * Write the grids of a batch of states into a single N*H*W tensor, without
+ * intermediate copies.
+ */
+inline void stack(std::span<State const* const> states, view<int8_t, -1, -1, -1> grids, unsigned num_threads = 1) {
+    game::stack(states, grids, [](State const* state) -> auto const& { return state->board.grid; }, num_threads);
+}
+
+inline tensor<int8_t, -1, -1, -1> stack(std::span<State const* const> states, unsigned num_threads = 1) {
+    return game::stack<int8_t, -1, -1>(states, [](State const* state) -> auto const& { return state->board.grid; }, num_threads);
 }
 
 
@@ -0,0 +1,253 @@
+#ifndef GAME_BOUNCE_BATCH_HPP
+#define GAME_BOUNCE_BATCH_HPP
+
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "./bounce.hpp"
+#include "./tensor.hpp"
+
+
+namespace game {
+namespace bounce {
+
+
+/*
+  Sample a valid initial grid in-place. The goal rows are left empty, the home
+  row of the first player is filled with random piece values, and the home row
+  of the second player is its point reflection, so that both sides are equal.
+*/
+template <typename Generator>
+void sample_grid(view<int8_t, -1, -1> grid, Generator& generator) {
+    int height = grid.shape()[0];
+    int width = grid.shape()[1];
+    if (height < 4 || width < 1)
+        throw shape_error();
+    std::uniform_int_distribution<int> distribution(1, 3);
+    grid.fill(0);
+    for (int x = 0; x < width; ++x) {
+        int8_t value = distribution(generator);
+        grid(1, x) = value;
+        grid(height - 2, width - 1 - x) = value;
+    }
+}
+
+template <typename Generator>
+Grid sample_grid(int height, int width, Generator& generator) {
+    Grid grid(height, width);
+    sample_grid(grid.as_view(), generator);
+    return grid;
+}
+
+
+/*
+  Many games played in lockstep, where all grids are stored in a single
+  contiguous tensor. Actions are given in the dense index space (see MoveId).
+  Moves are computed on bitboards (see BitWalk), hence boards have at most 64
+  cells.
+
+  A batch of actions is validated as a whole before any game is updated, so
+  that an invalid action leaves the environment unchanged.
+
+  Once a game has ended, its actions are ignored until it is reset. Resetting
+  samples a new initial grid in-place, hence no allocation occurs after the
+  first few steps.
+*/
+struct BatchEnv {
+    int height;
+    int width;
+
+    tensor<int8_t, -1, -1, -1> grids;
+    tensor<int8_t, -1> players;
+    tensor<int8_t, -1> winners;
+    tensor<float, -1, 2> rewards;
+    tensor<uint8_t, -1> dones;
+
+    std::mt19937_64 generator;
+    BitWalk walk;
+
+    struct Step {
+        view<int8_t const, -1, -1, -1> observations;
+        view<int8_t const, -1> players;
+        view<float const, -1, 2> rewards;
+        view<uint8_t const, -1> dones;
+    };
+
+    BatchEnv(int size, int height, int width, uint64_t seed = 0) :
+        height(check_shape(height, width)),
+        width(width),
+        grids(size, height, width),
+        players(size),
+        winners(size),
+        rewards(size),
+        dones(size),
+        generator(seed),
+        walk(height, width)
+    {
+        reset();
+    }
+
+    constexpr int size() const {
+        return grids.shape()[0];
+    }
+
+    constexpr int get_num_actions() const {
+        int cells = height * width;
+        return cells * cells;
+    }
+
+    void reset(int index) {
+        sample_grid(grids[index], generator);
+        players[index] = 0;
+        winners[index] = -1;
+        rewards[index].fill(0.0f);
+        dones[index] = 0;
+    }
+
+    void reset() {
+        for (int i = 0; i < size(); ++i)
+            reset(i);
+    }
+
+    void reset_done() {
+        for (int i = 0; i < size(); ++i)
+            if (dones[i])
+                reset(i);
+    }
+
+    void legal_mask(int index, view<uint8_t, -1> mask) {
+        int cells = height * width;
+        if (mask.size() != size_t(cells * cells))
+            throw shape_error();
+        mask.fill(0);
+        int player = players[index];
+        if (player < 0)
+            return;
+        walk.load(std::as_const(grids)[index]);
+        int y = walk.get_row(player);
+        int dy = player ? -1 : 1;
+        for (int x = 0; x < width; ++x) {
+            int source = y * width + x;
+            for (Bitboard targets = walk.get_targets(source, dy); targets; targets &= targets - 1)
+                mask[MoveId{ uint8_t(source), uint8_t(std::countr_zero(targets)) }.to_index(cells)] = 1;
+        }
+    }
+
+    void legal_mask(view<uint8_t, -1, -1> masks) {
+        if (masks.shape()[0] != size())
+            throw shape_error();
+        for (int i = 0; i < size(); ++i)
+            legal_mask(i, masks[i]);
+    }
+
+    // Whether the action is legal, or ignored as the game has ended
+    bool is_valid(int index, int action) {
+        int player = players[index];
+        if (player < 0)
+            return true;
+        int cells = height * width;
+        if (action < 0 || action >= cells * cells)
+            return false;
+        MoveId id = MoveId::from_index(action, cells);
+        walk.load(std::as_const(grids)[index]);
+        int dy = player ? -1 : 1;
+        return id.source / width == walk.get_row(player) && (walk.get_targets(id.source, dy) & (Bitboard(1) << id.target));
+    }
+
+    void step(int index, int action) {
+        if (!is_valid(index, action))
+            throw std::runtime_error("invalid move");
+        rewards[index].fill(0.0f);
+        if (players[index] >= 0)
+            play(index, MoveId::from_index(action, height * width));
+    }
+
+    Step step(view<int const, -1> actions) {
+        if (actions.size() != (size_t)size())
+            throw shape_error();
+        for (int i = 0; i < size(); ++i)
+            if (!is_valid(i, actions[i]))
+                throw std::runtime_error("invalid move");
+        for (int i = 0; i < size(); ++i) {
+            rewards[i].fill(0.0f);
+            if (players[i] >= 0) {
+                walk.load(std::as_const(grids)[i]);
+                play(i, MoveId::from_index(actions[i], height * width));
+            }
+        }
+        return {
+            std::as_const(grids).as_view(),
+            std::as_const(players).as_view(),
+            std::as_const(rewards).as_view(),
+            std::as_const(dones).as_view()
+        };
+    }
+
+private:
+
+    static int check_shape(int height, int width) {
+        if (!BitWalk::supports(height, width))
+            throw std::runtime_error("BatchEnv supports boards of at most 64 cells");
+        return height;
+    }
+
+    // Assumes that the action is valid, and that the walker is loaded with the current grid
+    void play(int index, MoveId id) {
+        int player = players[index];
+
+        // Move piece
+        int8_t* grid = grids[index].data();
+        int8_t value = grid[id.source];
+        grid[id.source] = 0;
+        grid[id.target] = value;
+        walk.apply(id.source, id.target);
+
+        // Check for victory, or whether next player is blocked
+        int y = id.target / width;
+        if (y == 0 || y == height - 1) {
+            winners[index] = player;
+            players[index] = -1;
+        }
+        else {
+            int next_player = player ? 0 : 1;
+            if (can_play(next_player))
+                players[index] = next_player;
+            else {
+                if (can_play(player))
+                    winners[index] = player;
+                players[index] = -1;
+            }
+        }
+
+        // Assign rewards on terminal transition
+        if (players[index] < 0) {
+            dones[index] = 1;
+            if (winners[index] >= 0) {
+                rewards[index][winners[index]] = 1.0f;
+                rewards[index][1 - winners[index]] = -1.0f;
+            }
+        }
+    }
+
+    // Assumes that the walker is loaded with the current grid
+    bool can_play(int player) {
+        int y = walk.get_row(player);
+        if (y < 0)
+            return false;
+        int dy = player ? -1 : 1;
+        for (int x = 0; x < width; ++x)
+            if (walk.get_targets(y * width + x, dy))
+                return true;
+        return false;
+    }
+};
+
+
+}
+}
+
+
+#endif
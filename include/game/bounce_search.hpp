@@ -0,0 +1,329 @@
+#ifndef GAME_BOUNCE_SEARCH_HPP
+#define GAME_BOUNCE_SEARCH_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "./bounce.hpp"
+#include "./hash.hpp"
+
+
+namespace game {
+namespace bounce {
+
+
+struct SearchResult {
+    int depth = 0;
+    int score = 0;
+    std::vector<Move> principal_variation;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+
+    double get_nodes_per_second() const {
+        return seconds > 0.0 ? nodes / seconds : 0.0;
+    }
+};
+
+
+/*
+  Iterative deepening negamax with alpha-beta pruning, intended as a baseline
+  opponent. Positions are represented by a BitWalk, where moves are applied and
+  undone in-place, so boards are restricted to 64 cells.
+
+  Scores are given from the perspective of the player to move. A win is worth
+  win_score minus the number of plies needed to reach it. Table entries only
+  cut off searches of the same depth, hence scores are exactly those of a plain
+  depth-limited negamax, whatever the previous searches.
+
+  The principal variation may end before the searched depth, if the table
+  entries it relies on were overwritten.
+*/
+struct Searcher {
+    static constexpr int win_score = 1000000;
+    static constexpr int max_ply = 256;
+
+    explicit Searcher(int table_bits = 20) : table(size_t(1) << table_bits) {}
+
+    void clear() {
+        std::fill(table.begin(), table.end(), Entry{});
+    }
+
+    /*
+      Cheap static evaluation, based on how close each player's active row is to
+      its goal, and on the values of the pieces in that row.
+    */
+    static int evaluate(BitWalk const& position, int player) {
+        return evaluate_side(position, player) - evaluate_side(position, player ? 0 : 1);
+    }
+
+    static int evaluate(State const& state) {
+        if (state.player < 0)
+            throw std::runtime_error("game has ended");
+        BitWalk position(state.board.grid);
+        return evaluate(position, state.player);
+    }
+
+    SearchResult search(State const& state, int max_depth, double max_seconds = std::numeric_limits<double>::infinity()) {
+        SearchResult result;
+        if (state.player < 0)
+            return result;
+
+        int width = state.board.get_width();
+        BitWalk position(state.board.grid);
+        nodes = 0;
+        aborted = false;
+        start = clock::now();
+        deadline = max_seconds;
+
+        for (int depth = 1; depth <= max_depth && depth < max_ply; ++depth) {
+            int score = negamax(position, state.player, depth, 0, -win_score - 1, win_score + 1);
+            if (aborted)
+                break;
+            result.depth = depth;
+            result.score = score;
+            std::vector<MoveId>& pv = principal_variations[0];
+            complete(position, state.player, depth, pv);
+            result.principal_variation.clear();
+            for (MoveId id : pv)
+                result.principal_variation.push_back(id.to_move(width));
+
+            // No need to look further once the outcome is known
+            if (std::abs(score) >= win_score - max_ply)
+                break;
+        }
+
+        result.nodes = nodes;
+        result.seconds = std::chrono::duration<double>(clock::now() - start).count();
+        return result;
+    }
+
+private:
+
+    using clock = std::chrono::steady_clock;
+
+    enum Bound : uint8_t { NONE, EXACT, LOWER, UPPER };
+
+    struct Entry {
+        size_t key = 0;
+        int32_t score = 0;
+        int16_t depth = -1;
+        Bound bound = NONE;
+        MoveId move = {};
+    };
+
+    std::vector<Entry> table;
+    std::vector<MoveId> moves[max_ply + 1];
+    std::vector<MoveId> principal_variations[max_ply + 1];
+    uint64_t nodes = 0;
+    bool aborted = false;
+    clock::time_point start;
+    double deadline = 0.0;
+
+    static int evaluate_side(BitWalk const& position, int player) {
+        int y = position.get_row(player);
+        if (y < 0)
+            return 0;
+        int width = position.width;
+        Bitboard row = (width < 64 ? (Bitboard(1) << width) - 1 : ~Bitboard(0)) << (y * width);
+        int distance = player ? y : position.height - 1 - y;
+        int reach = 0;
+        for (int value = 1; value <= 3; ++value)
+            reach += value * std::popcount(position.values[value - 1] & row);
+        return reach - 16 * distance;
+    }
+
+    static size_t get_key(BitWalk const& position, int player) {
+        return hash_many(position.occupied, position.values[0], position.values[1], position.values[2], player);
+    }
+
+    // Mate scores are stored relative to the current node
+    static int to_table(int score, int ply) {
+        if (score >= win_score - max_ply)
+            return score + ply;
+        if (score <= -win_score + max_ply)
+            return score - ply;
+        return score;
+    }
+
+    static int from_table(int score, int ply) {
+        if (score >= win_score - max_ply)
+            return score - ply;
+        if (score <= -win_score + max_ply)
+            return score + ply;
+        return score;
+    }
+
+    static void generate(BitWalk& position, int player, std::vector<MoveId>& result) {
+        result.clear();
+        int y = position.get_row(player);
+        if (y < 0)
+            return;
+        int width = position.width;
+        int dy = player ? -1 : 1;
+        for (int x = 0; x < width; ++x) {
+            int source = y * width + x;
+            for (Bitboard targets = position.get_targets(source, dy); targets; targets &= targets - 1)
+                result.push_back({ uint8_t(source), uint8_t(std::countr_zero(targets)) });
+        }
+    }
+
+    // Goal-reaching moves first, then by advance distance, then in generation order
+    static void order(BitWalk const& position, int player, MoveId best, std::vector<MoveId>& result) {
+        int width = position.width;
+        int height = position.height;
+        auto priority = [&](MoveId id) {
+            if (id == best)
+                return std::numeric_limits<int>::max();
+            int source_row = id.source / width;
+            int target_row = id.target / width;
+            if (target_row == 0 || target_row == height - 1)
+                return std::numeric_limits<int>::max() - 1;
+            return player ? source_row - target_row : target_row - source_row;
+        };
+        std::sort(result.begin(), result.end(), [&](MoveId a, MoveId b) {
+            int pa = priority(a);
+            int pb = priority(b);
+            if (pa != pb)
+                return pa > pb;
+            return std::pair(a.source, a.target) < std::pair(b.source, b.target);
+        });
+    }
+
+    /*
+      The principal variation is cut short where a child returns early from the
+      table, hence it is completed by following the best moves stored in the
+      table, as long as they are present and legal.
+    */
+    void complete(BitWalk position, int player, int depth, std::vector<MoveId>& pv) {
+        int width = position.width;
+        int height = position.height;
+        for (MoveId id : pv) {
+            int target_row = id.target / width;
+            if (target_row == 0 || target_row == height - 1)
+                return;
+            position.apply(id.source, id.target);
+            player = player ? 0 : 1;
+        }
+        std::vector<MoveId>& candidates = moves[0];
+        while (int(pv.size()) < depth) {
+            size_t key = get_key(position, player);
+            Entry const& entry = table[key & (table.size() - 1)];
+            if (entry.bound == NONE || entry.key != key)
+                return;
+            generate(position, player, candidates);
+            if (std::find(candidates.begin(), candidates.end(), entry.move) == candidates.end())
+                return;
+            pv.push_back(entry.move);
+            int target_row = entry.move.target / width;
+            if (target_row == 0 || target_row == height - 1)
+                return;
+            position.apply(entry.move.source, entry.move.target);
+            player = player ? 0 : 1;
+        }
+    }
+
+    int negamax(BitWalk& position, int player, int depth, int ply, int alpha, int beta) {
+        ++nodes;
+        if ((nodes & 1023) == 0 && std::chrono::duration<double>(clock::now() - start).count() > deadline)
+            aborted = true;
+        if (aborted)
+            return 0;
+
+        principal_variations[ply].clear();
+        int other = player ? 0 : 1;
+
+        // If current player cannot play, they lose, unless the other cannot either
+        std::vector<MoveId>& candidates = moves[ply];
+        generate(position, player, candidates);
+        if (candidates.empty()) {
+            std::vector<MoveId>& other_candidates = moves[ply + 1];
+            generate(position, other, other_candidates);
+            return other_candidates.empty() ? 0 : -win_score + ply;
+        }
+
+        if (depth <= 0 || ply + 1 >= max_ply)
+            return evaluate(position, player);
+
+        // Probe transposition table
+        size_t key = get_key(position, player);
+        Entry& entry = table[key & (table.size() - 1)];
+        MoveId best_move = candidates.front();
+        if (entry.bound != NONE && entry.key == key) {
+            best_move = entry.move;
+            if (ply > 0 && entry.depth == depth) {
+                int score = from_table(entry.score, ply);
+                if (entry.bound == EXACT ||
+                    (entry.bound == LOWER && score >= beta) ||
+                    (entry.bound == UPPER && score <= alpha))
+                    return score;
+            }
+        }
+
+        order(position, player, best_move, candidates);
+
+        int height = position.height;
+        int width = position.width;
+        int original_alpha = alpha;
+        int best_score = -win_score - 1;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            MoveId id = candidates[i];
+            int score;
+            int target_row = id.target / width;
+            if (target_row == 0 || target_row == height - 1)
+                score = win_score - ply - 1;
+            else {
+                position.apply(id.source, id.target);
+                score = -negamax(position, other, depth - 1, ply + 1, -beta, -alpha);
+                position.apply(id.target, id.source);
+            }
+            if (aborted)
+                return 0;
+
+            if (score > best_score) {
+                best_score = score;
+                best_move = id;
+            }
+            if (score > alpha) {
+                alpha = score;
+                std::vector<MoveId>& pv = principal_variations[ply];
+                pv.clear();
+                pv.push_back(id);
+                if (target_row != 0 && target_row != height - 1)
+                    pv.insert(pv.end(), principal_variations[ply + 1].begin(), principal_variations[ply + 1].end());
+            }
+            if (alpha >= beta)
+                break;
+        }
+
+        // Store result, preferring deeper searches
+        if (entry.key != key || depth >= entry.depth) {
+            entry.key = key;
+            entry.depth = depth;
+            entry.score = to_table(best_score, ply);
+            entry.move = best_move;
+            if (best_score <= original_alpha)
+                entry.bound = UPPER;
+            else if (best_score >= beta)
+                entry.bound = LOWER;
+            else
+                entry.bound = EXACT;
+        }
+
+        return best_score;
+    }
+};
+
+
+}
+}
+
+
+#endif
@@ -2,6 +2,8 @@
 #define GAME_COMPARISON_HPP
 
 
+#include <atomic>
+#include <concepts>
 #include <tuple>
 #include <type_traits>
 
@@ -11,11 +13,79 @@
 namespace game {
 
 
+/*
+ * Optional hash memoization. A Comparable type opts in by declaring a
+ * hash_cache member named cached_hash, which is filled lazily on first use. It
+ * must then be reset whenever the identity changes (e.g. in apply), or after
+ * directly editing the underlying data.
+ *
+ * The slot is atomic, so that concurrent lookups of a shared object are safe.
+ * Zero denotes an empty slot; objects that happen to hash to zero are simply
+ * rehashed every time.
+ */
+struct hash_cache {
+
+    hash_cache() = default;
+
+    hash_cache(hash_cache const& other) noexcept : value(other.value.load(std::memory_order_relaxed)) {}
+
+    hash_cache& operator=(hash_cache const& other) noexcept {
+        value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void reset() noexcept {
+        value.store(0, std::memory_order_relaxed);
+    }
+
+    bool has_value() const noexcept {
+        return value.load(std::memory_order_relaxed) != 0;
+    }
+
+    // Whether the objects may be equal, i.e. unless both hashes are known and differ
+    friend bool may_equal(hash_cache const& left, hash_cache const& right) noexcept {
+        size_t a = left.value.load(std::memory_order_relaxed);
+        size_t b = right.value.load(std::memory_order_relaxed);
+        return a == 0 || b == 0 || a == b;
+    }
+
+    template <typename F>
+    size_t get(F&& compute) const {
+        size_t result = value.load(std::memory_order_relaxed);
+        if (result == 0) {
+            result = compute();
+            value.store(result, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+
+    mutable std::atomic<size_t> value = 0;
+};
+
+
+/*
+ * Identity-based comparison. Equality is the hot path of hash tables, hence
+ * two optional shortcuts: memoized hashes are compared first, when available,
+ * and the derived type may provide an is_equal method, which must agree with
+ * the identity tuple. As the tuple also defines the ordering, its fields come
+ * in lexicographic order, usually grid first; is_equal may instead test cheap
+ * scalar fields (e.g. the player) first, and only then compare grids.
+ */
 template <typename Derived>
 struct Comparable {
 
     bool operator==(Comparable<Derived> const& right) const {
-        return derived().get_identity_tuple() == right.derived().get_identity_tuple();
+        Derived const& a = derived();
+        Derived const& b = right.derived();
+        if constexpr (requires { { a.cached_hash } -> std::same_as<hash_cache const&>; })
+            if (!may_equal(a.cached_hash, b.cached_hash))
+                return false;
+        if constexpr (requires { { a.is_equal(b) } -> std::convertible_to<bool>; })
+            return a.is_equal(b);
+        else
+            return a.get_identity_tuple() == b.get_identity_tuple();
     }
 
     auto operator<=>(Comparable<Derived> const& right) const {
@@ -35,7 +105,10 @@ private:
 template <typename Derived>
 struct hash<Derived, std::enable_if_t<std::is_base_of_v<Comparable<Derived>, Derived>>> {
     size_t operator()(Derived const& value) const {
-        return hash_value(value.derived().get_identity_tuple());
+        if constexpr (requires { { value.cached_hash } -> std::same_as<hash_cache const&>; })
+            return value.cached_hash.get([&] { return hash_value(value.derived().get_identity_tuple()); });
+        else
+            return hash_value(value.derived().get_identity_tuple());
     }
 };
 
@@ -0,0 +1,163 @@
+#ifndef GAME_CONCEPTS_HPP
+#define GAME_CONCEPTS_HPP
+
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "./comparison.hpp"
+#include "./tensor.hpp"
+
+
+namespace game {
+
+
+/*
+ * The informal protocol shared by all games (e.g. connect, bounce), so that
+ * generic code can be checked at compile time. A game is a namespace that
+ * defines three types, Config, State and Action, which refer to each other
+ * through nested aliases, and which are all Comparable (hence hashable).
+ *
+ * States and actions are handled through shared pointers, as actions keep a
+ * reference to their state.
+ */
+
+
+template <typename T>
+concept Identifiable = std::derived_from<T, Comparable<T>> && requires(T const& value) {
+    value.get_identity_tuple();
+};
+
+
+template <typename C>
+concept GameConfig = Identifiable<C> && requires(C& config, C const& const_config, nlohmann::json const& j) {
+    typename C::State;
+    typename C::Action;
+    { C::num_players } -> std::convertible_to<int>;
+    { config.sample_initial_state() } -> std::same_as<std::shared_ptr<typename C::State>>;
+    { const_config.to_json() } -> std::same_as<nlohmann::json>;
+    { C::from_json(j) } -> std::same_as<std::shared_ptr<C>>;
+};
+
+
+template <typename S>
+concept GameState = Identifiable<S> && requires(
+    S& state,
+    S const& const_state,
+    typename S::Action const& action,
+    nlohmann::json const& j,
+    std::shared_ptr<typename S::Config> const& config
+) {
+    typename S::Config;
+    typename S::Action;
+    { const_state.has_ended() } -> std::convertible_to<bool>;
+    { const_state.get_player() } -> std::convertible_to<int>;
+    { const_state.get_reward() } -> std::same_as<tensor<float, S::Config::num_players>>;
+    const_state.get_grid();
+    state.apply(action);
+    { state.get_actions() } -> std::same_as<std::vector<std::shared_ptr<typename S::Action>>>;
+    { const_state.to_json() } -> std::same_as<nlohmann::json>;
+    { S::from_json(j, config) } -> std::same_as<std::shared_ptr<S>>;
+};
+
+
+template <typename A>
+concept GameAction = Identifiable<A> && requires(
+    A const& action,
+    nlohmann::json const& j,
+    std::shared_ptr<typename A::State> const& state
+) {
+    typename A::Config;
+    typename A::State;
+    { action.sample_next_state() } -> std::same_as<std::shared_ptr<typename A::State>>;
+    { action.to_json() } -> std::same_as<nlohmann::json>;
+    { A::from_json(j, state) } -> std::same_as<std::shared_ptr<A>>;
+};
+
+
+// All three types, and their aliases must agree
+template <typename C>
+concept Game =
+    GameConfig<C> &&
+    GameState<typename C::State> &&
+    GameAction<typename C::Action> &&
+    std::same_as<typename C::State::Config, C> &&
+    std::same_as<typename C::State::Action, typename C::Action> &&
+    std::same_as<typename C::Action::Config, C> &&
+    std::same_as<typename C::Action::State, typename C::State>;
+
+
+/*
+ * Optional fast paths, detected at compile time, so that generic engines can
+ * select the fastest available implementation without virtual dispatch. Free
+ * functions are found by argument-dependent lookup, in the game namespace:
+ *  - dense actions: num_actions(config), action_index(action) and
+ *    action_from_index(state, index), i.e. a fixed-size policy output;
+ *  - moves: state.get_moves() lists small values (e.g. connect::Move,
+ *    bounce::MoveId), which state.apply validates, to avoid allocating actions;
+ *  - legal mask: legal_mask(state, mask), to avoid allocating actions;
+ *  - stack: stack(states, grids), to batch grids into a single tensor;
+ *  - hash cache: a memoized hash, see hash_cache;
+ *  - undo: state.undo(action), to search in place instead of copying;
+ *  - bitboard: a compact State::Position, constructible from the grid, where
+ *    moves are applied in place (e.g. bounce::BitWalk).
+ *
+ * Games may specialize game_traits, to disable a path or to override detection.
+ */
+template <typename State>
+    requires GameState<State>
+struct game_traits {
+    using config_type = typename State::Config;
+    using state_type = State;
+    using action_type = typename State::Action;
+
+    static constexpr int num_players = config_type::num_players;
+
+    static constexpr bool has_dense_actions = requires(config_type const& config, action_type const& action, State& state) {
+        { num_actions(config) } -> std::convertible_to<int>;
+        { action_index(action) } -> std::convertible_to<int>;
+        { action_from_index(state, 0) } -> std::same_as<std::shared_ptr<action_type>>;
+    };
+
+    static constexpr bool has_moves = requires(State& state) {
+        requires std::ranges::range<decltype(state.get_moves())>;
+        requires requires(std::ranges::range_value_t<decltype(state.get_moves())> move) {
+            requires std::is_trivially_copyable_v<decltype(move)>;
+            state.apply(move);
+            { state.is_legal(move) } -> std::convertible_to<bool>;
+        };
+    };
+
+    static constexpr bool has_legal_mask = requires(State const& state, view<uint8_t, -1> mask) {
+        legal_mask(state, mask);
+    };
+
+    static constexpr bool has_stack = requires(std::span<State const* const> states, view<int8_t, -1, -1, -1> grids) {
+        stack(states, grids);
+    };
+
+    static constexpr bool has_hash_cache = requires(State const& state) {
+        { state.cached_hash } -> std::same_as<hash_cache const&>;
+    };
+
+    static constexpr bool has_undo = requires(State& state, action_type const& action) {
+        state.undo(action);
+    };
+
+    static constexpr bool has_bitboard = requires(State const& state) {
+        requires std::constructible_from<typename State::Position, decltype(state.board.grid) const&>;
+    };
+};
+
+
+}
+
+
+#endif
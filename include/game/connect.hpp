@@ -3,12 +3,15 @@
 
 
 #include <memory>
+#include <span>
 #include <stdexcept>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include "./comparison.hpp"
+#include "./memory.hpp"
+#include "./simd.hpp"
 #include "./tensor.hpp"
 
 
@@ -48,13 +51,13 @@ struct Board {
         int h = height();
         int w = width();
         for (int column = 0; column < w; ++column)
-            if (grid[h - 1][column] < 0)
+            if (grid(h - 1, column) < 0)
                 return false;
         return true;
     }
 
     constexpr bool can_play_at(int column) const {
-        return column >= 0 && column < width() && grid[height() - 1][column] < 0;
+        return column >= 0 && column < width() && grid(height() - 1, column) < 0;
     }
 
     constexpr int play_at(int column, int player) {
@@ -62,46 +65,59 @@ struct Board {
         int w = width();
         if (column >= 0 && column < w)
             for (int row = 0; row < h; ++row)
-                if (grid[row][column] < 0) {
-                    grid[row][column] = player;
+                if (grid(row, column) < 0) {
+                    grid(row, column) = player;
                     return row;
                 }
         return -1;
     }
 
     constexpr int count_at(int row, int column) const {
-        int player = grid[row][column];
+        int player = grid(row, column);
         int h = height();
         int w = width();
 
         int u = 1;
-        for (int j = column; j > 0 && grid[row][--j] == player; ++u);
-        for (int j = column; j < w - 1 && grid[row][++j] == player; ++u);
+        for (int j = column; j > 0 && grid(row, --j) == player; ++u);
+        for (int j = column; j < w - 1 && grid(row, ++j) == player; ++u);
 
         int v = 1;
-        for (int i = row; i > 0 && grid[--i][column] == player; ++v);
-        for (int i = row; i < h - 1 && grid[++i][column] == player; ++v);
+        for (int i = row; i > 0 && grid(--i, column) == player; ++v);
+        for (int i = row; i < h - 1 && grid(++i, column) == player; ++v);
 
         int a = 1;
-        for (int i = row, j_ = column; i > 0 && j_ > 0 && grid[--i][--j_] == player; ++a);
-        for (int i = row, j_ = column; i < h - 1 && j_ < w - 1 && grid[++i][++j_] == player; ++a);
+        for (int i = row, j_ = column; i > 0 && j_ > 0 && grid(--i, --j_) == player; ++a);
+        for (int i = row, j_ = column; i < h - 1 && j_ < w - 1 && grid(++i, ++j_) == player; ++a);
 
         int b = 1;
-        for (int i = row, j = column; i > 0 && j < w - 1 && grid[--i][++j] == player; ++b);
-        for (int i = row, j = column; i < h - 1 && j > 0 && grid[++i][--j] == player; ++b);
+        for (int i = row, j = column; i > 0 && j < w - 1 && grid(--i, ++j) == player; ++b);
+        for (int i = row, j = column; i < h - 1 && j > 0 && grid(++i, --j) == player; ++b);
 
         return std::max({ u, v, a, b });
     }
 
+    constexpr bool operator==(Board const& right) const {
+        return grid == right.grid;
+    }
+
     constexpr auto operator<=>(Board const& right) const {
-        return std::lexicographical_compare_three_way(
-            grid.data(), grid.data() + grid.size(),
-            right.grid.data(), right.grid.data() + right.grid.size()
-        );
+        return simd::compare_three_way(grid.data(), grid.size(), right.grid.data(), right.grid.size());
     }
 };
 
 
+/*
+  Lightweight alternative to Action, which is only the payload, i.e. the column.
+  It is applied to an explicitly passed state, which validates it, hence listing
+  moves does not allocate one shared object per action.
+*/
+struct Move {
+    unsigned column;
+
+    constexpr auto operator<=>(Move const& right) const noexcept = default;
+};
+
+
 struct Config;
 struct State;
 struct Action;
@@ -161,6 +177,9 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
     int8_t player;
     int8_t winner;
 
+    // Hash of the identity, reset by apply
+    hash_cache cached_hash;
+
     State(std::shared_ptr<Config> const& config) :
         config(config),
         board(config->height, config->width),
@@ -193,10 +212,32 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
 
     void apply(Action const& action);
 
+    bool is_legal(Move move) const {
+        return player >= 0 && board.can_play_at(move.column);
+    }
+
+    std::vector<Move> get_moves() const {
+        std::vector<Move> result;
+        result.reserve(config->width);
+        if (player >= 0)
+            for (int column = 0; column < config->width; ++column)
+                if (board.can_play_at(column))
+                    result.push_back({ unsigned(column) });
+        return result;
+    }
+
+    void apply(Move move) {
+        if (!is_legal(move))
+            throw std::runtime_error("invalid move");
+        apply_unchecked(move);
+    }
+
+    void apply_unchecked(Move move);
+
     std::shared_ptr<Action> get_action_at(int column) {
         if (player < 0 || !board.can_play_at(column))
             throw std::runtime_error("invalid move");
-        return std::make_shared<Action>(shared_from_this(), column);
+        return game::allocate_shared<Action>(shared_from_this(), column);
     }
 
     std::vector<std::shared_ptr<Action>> get_actions() {
@@ -212,6 +253,10 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
         return std::tie(board.grid, player);
     }
 
+    bool is_equal(State const& right) const {
+        return player == right.player && board.grid == right.board.grid;
+    }
+
     nlohmann::json to_json() const {
         return {
             { "grid", board.grid },
@@ -220,7 +265,7 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
     }
 
     static std::shared_ptr<State> from_json(nlohmann::json const& j, std::shared_ptr<Config> const& config) {
-        auto state = std::make_shared<State>(config);
+        auto state = game::allocate_shared<State>(config);
         j.at("grid").get_to(state->board.grid);
         j.at("player").get_to(state->player);
         // TODO set winner accordingly
@@ -232,7 +277,7 @@ struct State : std::enable_shared_from_this<State>, Comparable<State> {
 
 
 std::shared_ptr<State> Config::sample_initial_state() {
-    return std::make_shared<State>(shared_from_this());
+    return game::allocate_shared<State>(shared_from_this());
 }
 
 
@@ -243,21 +288,32 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
     std::shared_ptr<State> state;
     unsigned column;
 
+    // Hash of the identity, which assumes that the state is not modified in place
+    hash_cache cached_hash;
+
     Action(std::shared_ptr<State> const& state, unsigned column) :
         state(state),
         column(column)
     {}
 
     std::shared_ptr<State> sample_next_state() const {
-        std::shared_ptr<State> next_state = std::make_shared<State>(*state);
+        std::shared_ptr<State> next_state = game::allocate_shared<State>(*state);
         next_state->apply(*this);
         return next_state;
     }
 
+    Move get_move() const {
+        return { column };
+    }
+
     auto get_identity_tuple() const {
         return std::tie(state->board.grid, state->player, column);
     }
 
+    bool is_equal(Action const& right) const {
+        return column == right.column && (state == right.state || *state == *right.state);
+    }
+
     nlohmann::json to_json() const {
         return {
             { "column", column }
@@ -267,7 +323,7 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
     static std::shared_ptr<Action> from_json(nlohmann::json const& j, std::shared_ptr<State> const& state) {
         unsigned column = 0;
         j.at("column").get_to(column);
-        auto action = std::make_shared<Action>(state, column);
+        auto action = game::allocate_shared<Action>(state, column);
         // TODO check that column is valid
         return action;
     }
@@ -275,10 +331,17 @@ struct Action : std::enable_shared_from_this<Action>, Comparable<Action> {
 
 
 void State::apply(Action const& action) {
-    int row = board.play_at(action.column, player);
+    apply_unchecked(action.get_move());
+}
+
+
+// The column is still checked by the board, but not whether the game has ended
+void State::apply_unchecked(Move move) {
+    cached_hash.reset();
+    int row = board.play_at(move.column, player);
     if (row < 0)
         throw std::runtime_error("invalid move");
-    if (board.count_at(row, action.column) >= config->count) {
+    if (board.count_at(row, move.column) >= config->count) {
         winner = player;
         player = -1;
         return;
@@ -291,6 +354,52 @@ void State::apply(Action const& action) {
 }
 
 
+/*
+  Dense action space, where each column is an action. This is meant to be used as
+  a fixed-size policy output, along with a mask of legal actions.
+*/
+
+inline int num_actions(Config const& config) {
+    return config.width;
+}
+
+inline int action_index(Action const& action) {
+    return action.column;
+}
+
+inline std::shared_ptr<Action> action_from_index(State& state, int index) {
+    return state.get_action_at(index);
+}
+
+inline void legal_mask(State const& state, view<uint8_t, -1> mask) {
+    int width = state.board.width();
+    if (mask.size() != (size_t)width)
+        throw shape_error();
+    for (int column = 0; column < width; ++column)
+        mask[column] = state.player >= 0 && state.board.can_play_at(column);
+}
+
+inline void legal_mask(std::span<State const* const> states, view<uint8_t, -1, -1> masks) {
+    if (masks.shape()[0] != (dim_t)states.size())
+        throw shape_error();
+    for (size_t i = 0; i < states.size(); ++i)
+        legal_mask(*states[i], masks[i]);
+}
+
+
+/*
+ * Write the grids of a batch of states into a single N*H*W tensor, without
+ * intermediate copies.
+ */
+inline void stack(std::span<State const* const> states, view<int8_t, -1, -1, -1> grids, unsigned num_threads = 1) {
+    game::stack(states, grids, [](State const* state) -> auto const& { return state->board.grid; }, num_threads);
+}
+
+inline tensor<int8_t, -1, -1, -1> stack(std::span<State const* const> states, unsigned num_threads = 1) {
+    return game::stack<int8_t, -1, -1>(states, [](State const* state) -> auto const& { return state->board.grid; }, num_threads);
+}
+
+
 }
 }
 
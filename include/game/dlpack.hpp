@@ -0,0 +1,257 @@
+#ifndef GAME_DLPACK_HPP
+#define GAME_DLPACK_HPP
+
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "./shape.hpp"
+#include "./tensor.hpp"
+
+
+/*
+ * DLPack is the common in-memory tensor structure, used to exchange buffers
+ * between frameworks without copying (e.g. torch.from_dlpack, numpy.from_dlpack):
+ *   https://dmlc.github.io/dlpack/latest/
+ *
+ * If dlpack/dlpack.h is available, or if another DLPack header (e.g. the one
+ * bundled with ATen) was included before, it is used. Otherwise, the subset of
+ * the ABI (version 0.8) needed here is declared, under a private guard. Since
+ * the official guard is left undefined, including a full DLPack header after
+ * this one is reported as a redefinition, rather than silently skipped.
+ */
+
+#if __has_include(<dlpack/dlpack.h>)
+#include <dlpack/dlpack.h>
+#endif
+
+#if !defined(DLPACK_DLPACK_H_) && !defined(GAME_DLPACK_ABI_HPP)
+#define GAME_DLPACK_ABI_HPP
+
+#define DLPACK_VERSION 80
+#define DLPACK_ABI_VERSION 1
+
+extern "C" {
+
+typedef enum {
+    kDLCPU = 1,
+    kDLCUDA = 2,
+    kDLCUDAHost = 3,
+    kDLOpenCL = 4,
+    kDLVulkan = 7,
+    kDLMetal = 8,
+    kDLVPI = 9,
+    kDLROCM = 10,
+    kDLROCMHost = 11,
+    kDLExtDev = 12,
+    kDLCUDAManaged = 13,
+    kDLOneAPI = 14,
+    kDLWebGPU = 15,
+    kDLHexagon = 16,
+} DLDeviceType;
+
+typedef struct {
+    DLDeviceType device_type;
+    int32_t device_id;
+} DLDevice;
+
+typedef enum {
+    kDLInt = 0U,
+    kDLUInt = 1U,
+    kDLFloat = 2U,
+    kDLOpaqueHandle = 3U,
+    kDLBfloat = 4U,
+    kDLComplex = 5U,
+    kDLBool = 6U,
+} DLDataTypeCode;
+
+typedef struct {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+} DLDataType;
+
+typedef struct {
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;
+    uint64_t byte_offset;
+} DLTensor;
+
+typedef struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void (*deleter)(struct DLManagedTensor* self);
+} DLManagedTensor;
+
+}
+
+#endif
+
+
+namespace game {
+
+
+/*
+ * Data type descriptor, for the arithmetic types used in tensors (e.g. int8_t
+ * grids, int masks, float rewards).
+ */
+template <typename T>
+constexpr DLDataType dlpack_dtype() {
+    using U = std::remove_cv_t<T>;
+    static_assert(std::is_arithmetic_v<U>, "unsupported element type");
+    uint8_t code;
+    if constexpr (std::is_same_v<U, bool>)
+        code = kDLBool;
+    else if constexpr (std::is_floating_point_v<U>)
+        code = kDLFloat;
+    else if constexpr (std::is_signed_v<U>)
+        code = kDLInt;
+    else
+        code = kDLUInt;
+    return { code, uint8_t(8 * sizeof(U)), 1 };
+}
+
+
+namespace detail {
+
+template <unsigned N>
+struct dlpack_shape {
+    std::array<int64_t, N> shape;
+    std::array<int64_t, N> strides;
+
+    template <typename Shape>
+    void assign(Shape const& value) {
+        auto dims = value.to_array();
+        int64_t stride = 1;
+        for (unsigned i = N; i-- > 0;) {
+            shape[i] = dims[i];
+            strides[i] = stride;
+            stride *= dims[i];
+        }
+    }
+};
+
+template <typename Owner, unsigned N>
+struct dlpack_context {
+    Owner owner;
+    dlpack_shape<N> shape;
+    DLManagedTensor managed;
+
+    static void deleter(DLManagedTensor* self) {
+        delete static_cast<dlpack_context*>(self->manager_ctx);
+    }
+};
+
+// The data pointer is left to the caller, as moving the owner may relocate it
+template <typename T, unsigned N, typename Owner, typename Shape>
+dlpack_context<Owner, N>* make_dlpack(Owner owner, Shape const& shape) {
+    auto context = new dlpack_context<Owner, N>{ std::move(owner), {}, {} };
+    context->shape.assign(shape);
+    DLManagedTensor& managed = context->managed;
+    managed.dl_tensor.device = { kDLCPU, 0 };
+    managed.dl_tensor.ndim = N;
+    managed.dl_tensor.dtype = dlpack_dtype<T>();
+    managed.dl_tensor.shape = context->shape.shape.data();
+    managed.dl_tensor.strides = context->shape.strides.data();
+    managed.dl_tensor.byte_offset = 0;
+    managed.manager_ctx = context;
+    managed.deleter = &dlpack_context<Owner, N>::deleter;
+    return context;
+}
+
+struct dlpack_none {};
+
+}
+
+
+/*
+ * Export a tensor, which is moved into the managed structure. Dynamic tensors
+ * that are stored on the heap are handed over without any copy.
+ *
+ * The consumer takes ownership, and must eventually call the deleter.
+ */
+template <typename T, dim_t Head, dim_t... Tail>
+DLManagedTensor* to_dlpack(tensor<T, Head, Tail...>&& value) {
+    constexpr unsigned N = 1 + sizeof...(Tail);
+    auto shape = value.shape();
+    auto context = detail::make_dlpack<T, N>(std::move(value), shape);
+    context->managed.dl_tensor.data = context->owner.data();
+    return &context->managed;
+}
+
+
+/*
+ * Export a view, without copy. Only the shape is owned by the managed
+ * structure; the underlying storage must outlive it. Note that DLPack has no
+ * notion of constness, hence a consumer must not write into a const view.
+ */
+template <typename T, dim_t Head, dim_t... Tail>
+DLManagedTensor* to_dlpack(view<T, Head, Tail...> value) {
+    constexpr unsigned N = 1 + sizeof...(Tail);
+    auto context = detail::make_dlpack<T, N>(detail::dlpack_none{}, value.shape());
+    context->managed.dl_tensor.data = const_cast<std::remove_const_t<T>*>(value.data());
+    return &context->managed;
+}
+
+
+/*
+ * Wrap external memory as a view, without copy. The buffer must reside on the
+ * CPU, have the expected type and rank, and be stored densely in row-major
+ * order. The view is only valid as long as the producer keeps the memory alive.
+ */
+template <typename T, dim_t Head, dim_t... Tail>
+view<T, Head, Tail...> from_dlpack(DLTensor const& value) {
+    constexpr unsigned N = 1 + sizeof...(Tail);
+
+    if (value.device.device_type != kDLCPU && value.device.device_type != kDLCUDAHost)
+        throw std::invalid_argument("unsupported device");
+
+    DLDataType dtype = dlpack_dtype<T>();
+    if (value.dtype.code != dtype.code || value.dtype.bits != dtype.bits || value.dtype.lanes != dtype.lanes)
+        throw std::invalid_argument("unsupported data type");
+
+    if (value.ndim != int32_t(N))
+        throw shape_error();
+
+    std::array<dim_t, N> dims;
+    for (unsigned i = 0; i < N; ++i) {
+        if (value.shape[i] < 0 || value.shape[i] > std::numeric_limits<dim_t>::max())
+            throw shape_error();
+        dims[i] = dim_t(value.shape[i]);
+    }
+    shape_t<Head, Tail...> shape = {};
+    if (!shape.from_array(dims))
+        throw shape_error();
+
+    // Missing strides imply a compact row-major layout; strides of unit dimensions are irrelevant
+    if (value.strides) {
+        int64_t stride = 1;
+        for (unsigned i = N; i-- > 0;) {
+            if (value.shape[i] != 1 && value.strides[i] != stride)
+                throw std::invalid_argument("tensor is not contiguous");
+            stride *= value.shape[i];
+        }
+    }
+
+    T* data = reinterpret_cast<T*>(static_cast<char*>(value.data) + value.byte_offset);
+    return view<T, Head, Tail...>(data, shape);
+}
+
+template <typename T, dim_t Head, dim_t... Tail>
+view<T, Head, Tail...> from_dlpack(DLManagedTensor const* value) {
+    return from_dlpack<T, Head, Tail...>(value->dl_tensor);
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,357 @@
+#ifndef GAME_EXPRESSION_HPP
+#define GAME_EXPRESSION_HPP
+
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "./shape.hpp"
+#include "./tensor.hpp"
+
+
+namespace game {
+
+
+/*
+ * Lazy elementwise arithmetic on tensors and views. Operators build a tree of
+ * expressions, which is only evaluated when assigned to a tensor or view (or
+ * reduced), in a single loop and without temporaries. When all shapes are known
+ * at compile time, so is the loop count.
+ *
+ * Expressions only keep pointers to their operands, hence they must not outlive
+ * them; prefer using them directly rather than storing them.
+ *
+ * As operator== and operator<=> already compare whole tensors, elementwise
+ * comparisons are provided as named functions (equal, less, ...).
+ */
+
+
+/*
+ * Leaf, referring to the storage of a tensor or a view.
+ */
+template <typename T, typename Shape>
+struct expression_leaf {
+    using value_type = std::remove_const_t<T>;
+    using shape_type = Shape;
+
+    T const* pointer;
+    Shape shape_;
+
+    constexpr Shape shape() const {
+        return shape_;
+    }
+
+    constexpr T const& operator[](size_t index) const {
+        return pointer[index];
+    }
+};
+
+
+/*
+ * Leaf, broadcasting a scalar value.
+ */
+template <typename T>
+struct expression_scalar {
+    using value_type = T;
+
+    T value;
+
+    constexpr T const& operator[](size_t) const {
+        return value;
+    }
+};
+
+
+template <typename T>
+inline constexpr bool is_expression_scalar_v = false;
+
+template <typename T>
+inline constexpr bool is_expression_scalar_v<expression_scalar<T>> = true;
+
+
+/*
+ * Convert operands to expression nodes.
+ */
+template <typename T, dim_t... D>
+constexpr auto make_operand(tensor<T, D...> const& value) {
+    return expression_leaf<T, shape_t<D...>>{ value.data(), value.shape() };
+}
+
+template <typename T, dim_t... D>
+constexpr auto make_operand(view<T, D...> const& value) {
+    return expression_leaf<T, shape_t<D...>>{ value.data(), value.shape() };
+}
+
+template <typename Op, typename... Args>
+constexpr auto const& make_operand(expression<Op, Args...> const& value) {
+    return value;
+}
+
+template <typename T>
+    requires std::is_arithmetic_v<T>
+constexpr auto make_operand(T value) {
+    return expression_scalar<T>{ value };
+}
+
+
+template <typename T>
+inline constexpr bool is_array_operand_v = is_expression_v<T>;
+
+template <typename T, dim_t... D>
+inline constexpr bool is_array_operand_v<tensor<T, D...>> = true;
+
+template <typename T, dim_t... D>
+inline constexpr bool is_array_operand_v<view<T, D...>> = true;
+
+template <typename T>
+inline constexpr bool is_operand_v = is_array_operand_v<T> || std::is_arithmetic_v<T>;
+
+
+/*
+ * Elementwise operation over one or more nodes. The shape is taken from the
+ * first non-scalar operand, preferring compile-time shapes.
+ */
+template <typename Op, typename... Args>
+struct expression {
+    using value_type = decltype(std::declval<Op>()(std::declval<typename Args::value_type>()...));
+
+    Op op;
+    std::tuple<Args...> args;
+
+private:
+
+    template <typename Arg>
+    static constexpr int shape_rank() {
+        if constexpr (is_expression_scalar_v<Arg>)
+            return 0;
+        else if constexpr (std::is_empty_v<typename Arg::shape_type>)
+            return 2;
+        else
+            return 1;
+    }
+
+    static constexpr size_t shape_source() {
+        constexpr int ranks[] = { shape_rank<Args>()... };
+        size_t best = 0;
+        for (size_t i = 1; i < sizeof...(Args); ++i)
+            if (ranks[i] > ranks[best])
+                best = i;
+        return best;
+    }
+
+public:
+
+    using shape_type = typename std::tuple_element_t<shape_source(), std::tuple<Args...>>::shape_type;
+
+    static constexpr bool is_static = std::is_empty_v<shape_type>;
+
+    constexpr expression(Op op, Args const&... args) : op(op), args(args...) {
+        check_shapes(std::index_sequence_for<Args...>());
+    }
+
+    constexpr shape_type shape() const {
+        return std::get<shape_source()>(args).shape();
+    }
+
+    constexpr size_t size() const {
+        return shape().product();
+    }
+
+    constexpr value_type operator[](size_t index) const {
+        return std::apply([&](Args const&... a) { return op(a[index]...); }, args);
+    }
+
+private:
+
+    template <size_t... I>
+    constexpr void check_shapes(std::index_sequence<I...>) const {
+        (check_shape(std::get<I>(args)), ...);
+    }
+
+    template <typename Arg>
+    constexpr void check_shape(Arg const& arg) const {
+        if constexpr (!is_expression_scalar_v<Arg>) {
+            if constexpr (is_static && std::is_empty_v<typename Arg::shape_type>)
+                static_assert(shape_type{} == typename Arg::shape_type{}, "shape mismatch");
+            else if (arg.shape() != shape())
+                throw shape_error();
+        }
+    }
+};
+
+
+template <typename Op, typename... Args>
+constexpr auto make_expression(Op op, Args const&... args) {
+    return expression<Op, std::decay_t<decltype(make_operand(args))>...>(op, make_operand(args)...);
+}
+
+
+/*
+ * Evaluation, in a single loop.
+ */
+template <typename T, dim_t... D, typename E>
+    requires is_expression_v<E>
+constexpr void assign(view<T, D...> destination, E const& e) {
+    if (destination.shape() != e.shape())
+        throw shape_error();
+    T* target = destination.data();
+    if constexpr (E::is_static) {
+        constexpr size_t size = typename E::shape_type{}.product();
+        for (size_t i = 0; i < size; ++i)
+            target[i] = static_cast<T>(e[i]);
+    }
+    else {
+        size_t size = e.size();
+        for (size_t i = 0; i < size; ++i)
+            target[i] = static_cast<T>(e[i]);
+    }
+}
+
+template <typename T, dim_t... D, typename E>
+    requires is_expression_v<E>
+constexpr void assign(tensor<T, D...>& destination, E const& e) {
+    shape_t<D...> shape = destination.shape();
+    if (!shape.from_array(e.shape().to_array()))
+        throw shape_error();
+    destination.reshape(shape);
+    assign(destination.as_view(), e);
+}
+
+template <typename T, typename Shape>
+struct tensor_of_shape;
+
+template <typename T, dim_t... D>
+struct tensor_of_shape<T, shape_t<D...>> {
+    using type = tensor<T, D...>;
+};
+
+template <typename E>
+    requires is_expression_v<E>
+constexpr auto eval(E const& e) {
+    using result_type = typename tensor_of_shape<typename E::value_type, typename E::shape_type>::type;
+    result_type result(e.shape());
+    assign(result.as_view(), e);
+    return result;
+}
+
+
+/*
+ * Operators.
+ */
+
+#define GAME_EXPRESSION_BINARY(NAME, OP)                                                     \
+template <typename L, typename R>                                                            \
+    requires (is_operand_v<L> && is_operand_v<R> && (is_array_operand_v<L> || is_array_operand_v<R>)) \
+constexpr auto NAME(L const& left, R const& right) {                                         \
+    return make_expression(OP{}, left, right);                                               \
+}                                                                                            \
+
+GAME_EXPRESSION_BINARY(operator+, std::plus<>)
+GAME_EXPRESSION_BINARY(operator-, std::minus<>)
+GAME_EXPRESSION_BINARY(operator*, std::multiplies<>)
+GAME_EXPRESSION_BINARY(operator/, std::divides<>)
+GAME_EXPRESSION_BINARY(equal, std::equal_to<>)
+GAME_EXPRESSION_BINARY(not_equal, std::not_equal_to<>)
+GAME_EXPRESSION_BINARY(less, std::less<>)
+GAME_EXPRESSION_BINARY(less_equal, std::less_equal<>)
+GAME_EXPRESSION_BINARY(greater, std::greater<>)
+GAME_EXPRESSION_BINARY(greater_equal, std::greater_equal<>)
+GAME_EXPRESSION_BINARY(minimum, decltype([](auto a, auto b) { return b < a ? b : a; }))
+GAME_EXPRESSION_BINARY(maximum, decltype([](auto a, auto b) { return a < b ? b : a; }))
+
+#undef GAME_EXPRESSION_BINARY
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr auto operator-(E const& value) {
+    return make_expression(std::negate<>{}, value);
+}
+
+template <typename C, typename L, typename R>
+    requires (is_array_operand_v<C> && is_operand_v<L> && is_operand_v<R>)
+constexpr auto where(C const& condition, L const& left, R const& right) {
+    auto op = [](auto c, auto a, auto b) -> std::common_type_t<decltype(a), decltype(b)> { return c ? a : b; };
+    return make_expression(op, condition, left, right);
+}
+
+template <typename T, typename E>
+    requires is_array_operand_v<E>
+constexpr auto cast(E const& value) {
+    return make_expression([](auto a) { return static_cast<T>(a); }, value);
+}
+
+
+/*
+ * Reductions.
+ */
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr auto sum(E const& value) {
+    auto e = make_operand(value);
+    using result_type = decltype(e[0] + e[0]);
+    result_type result = {};
+    size_t size = e.shape().product();
+    for (size_t i = 0; i < size; ++i)
+        result += e[i];
+    return result;
+}
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr auto min(E const& value) {
+    auto e = make_operand(value);
+    size_t size = e.shape().product();
+    if (size == 0)
+        throw shape_error();
+    auto result = e[0];
+    for (size_t i = 1; i < size; ++i)
+        if (e[i] < result)
+            result = e[i];
+    return result;
+}
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr auto max(E const& value) {
+    auto e = make_operand(value);
+    size_t size = e.shape().product();
+    if (size == 0)
+        throw shape_error();
+    auto result = e[0];
+    for (size_t i = 1; i < size; ++i)
+        if (result < e[i])
+            result = e[i];
+    return result;
+}
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr bool any(E const& value) {
+    auto e = make_operand(value);
+    size_t size = e.shape().product();
+    for (size_t i = 0; i < size; ++i)
+        if (e[i])
+            return true;
+    return false;
+}
+
+template <typename E>
+    requires is_array_operand_v<E>
+constexpr bool all(E const& value) {
+    auto e = make_operand(value);
+    size_t size = e.shape().product();
+    for (size_t i = 0; i < size; ++i)
+        if (!e[i])
+            return false;
+    return true;
+}
+
+
+}
+
+
+#endif
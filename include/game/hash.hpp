@@ -4,9 +4,14 @@
 
 #include <array>
 #include <bit>
+#include <compare>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <ranges>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 
@@ -92,17 +97,150 @@ size_t hash_many(Ts const&... values) {
     return seed;
 }
 
+/*
+ * Contiguous ranges of integers (e.g. game grids) are hashed as raw bytes, 16
+ * to 48 bytes per step, using wyhash (final version 4):
+ *   https://github.com/wangyi-fudan/wyhash
+ * Integers are their own hash, so equal ranges have equal bytes, and vice
+ * versa. This does not hold for floating-point numbers (e.g. signed zeros) or
+ * arbitrary structures (e.g. padding), which are still hashed per element.
+ *
+ * Bytes are read in little-endian order, hence the result is deterministic,
+ * for a given size_t width.
+ */
+
+namespace detail {
+
+inline uint64_t wyhash_read64(unsigned char const* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    if constexpr (std::endian::native == std::endian::big) {
+        v = ((v & 0x00000000ffffffffull) << 32) | (v >> 32);
+        v = ((v & 0x0000ffff0000ffffull) << 16) | ((v >> 16) & 0x0000ffff0000ffffull);
+        v = ((v & 0x00ff00ff00ff00ffull) << 8) | ((v >> 8) & 0x00ff00ff00ff00ffull);
+    }
+    return v;
+}
+
+inline uint64_t wyhash_read32(unsigned char const* p) {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    if constexpr (std::endian::native == std::endian::big) {
+        v = (v << 16) | (v >> 16);
+        v = ((v & 0x00ff00ffu) << 8) | ((v >> 8) & 0x00ff00ffu);
+    }
+    return v;
+}
+
+inline uint64_t wyhash_read3(unsigned char const* p, size_t k) {
+    return (uint64_t(p[0]) << 16) | (uint64_t(p[k >> 1]) << 8) | p[k - 1];
+}
+
+// 64x64 to 128-bit multiplication, returning the low and high halves
+inline void wyhash_multiply(uint64_t& a, uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = a;
+    r *= b;
+    a = uint64_t(r);
+    b = uint64_t(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    a = lo;
+    b = hi;
+#endif
+}
+
+inline uint64_t wyhash_mix(uint64_t a, uint64_t b) {
+    wyhash_multiply(a, b);
+    return a ^ b;
+}
+
+inline constexpr uint64_t wyhash_secret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+}
+
+inline uint64_t wyhash(void const* data, size_t size, uint64_t seed) {
+    using namespace detail;
+    auto const& s = wyhash_secret;
+    unsigned char const* p = static_cast<unsigned char const*>(data);
+    seed ^= wyhash_mix(seed ^ s[0], s[1]);
+    uint64_t a, b;
+    if (size <= 16) {
+        if (size >= 4) {
+            a = (wyhash_read32(p) << 32) | wyhash_read32(p + ((size >> 3) << 2));
+            b = (wyhash_read32(p + size - 4) << 32) | wyhash_read32(p + size - 4 - ((size >> 3) << 2));
+        }
+        else if (size > 0) {
+            a = wyhash_read3(p, size);
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        size_t i = size;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wyhash_mix(wyhash_read64(p) ^ s[1], wyhash_read64(p + 8) ^ seed);
+                see1 = wyhash_mix(wyhash_read64(p + 16) ^ s[2], wyhash_read64(p + 24) ^ see1);
+                see2 = wyhash_mix(wyhash_read64(p + 32) ^ s[3], wyhash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wyhash_mix(wyhash_read64(p) ^ s[1], wyhash_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wyhash_read64(p + i - 16);
+        b = wyhash_read64(p + i - 8);
+    }
+    a ^= s[1];
+    b ^= seed;
+    wyhash_multiply(a, b);
+    return wyhash_mix(a ^ s[0] ^ size, b ^ s[1]);
+}
+
+inline size_t hash_bytes(void const* data, size_t size) {
+    uint64_t h = wyhash(data, size, hash_basis);
+    if constexpr (sizeof(size_t) == 4)
+        return size_t(h ^ (h >> 32));
+    else
+        return size_t(h);
+}
+
+template <typename T>
+inline constexpr bool is_bytewise_hashable_v = std::is_integral_v<T>;
+
+
 template <typename It>
 size_t hash_range(It first, It last) {
-    size_t seed = hash_basis;
-    for (; first != last; ++first)
-        hash_combine(seed, *first);
-    return seed;
+    if constexpr (std::contiguous_iterator<It> && is_bytewise_hashable_v<std::iter_value_t<It>>) {
+        size_t size = last - first;
+        return hash_bytes(std::to_address(first), size * sizeof(std::iter_value_t<It>));
+    }
+    else {
+        size_t seed = hash_basis;
+        for (; first != last; ++first)
+            hash_combine(seed, *first);
+        return seed;
+    }
 }
 
 template <typename Container>
 size_t hash_range(Container const& container) {
-    return hash_range(container.begin(), container.end());
+    return hash_range(std::begin(container), std::end(container));
 }
 
 
@@ -197,6 +335,93 @@ struct hash<std::shared_ptr<T>> {
 
 
 
+/*
+ * Incremental hashing, to fingerprint a sequence of values (e.g. a trajectory,
+ * ply by ply, or a batch of states) without building an intermediate tuple.
+ *
+ * Each update is absorbed as a separate, length-delimited record, hence
+ * update_bytes("ab", 2) followed by update_bytes("c", 1) differs from
+ * update_bytes("abc", 3). Values are fed recursively: integers and contiguous
+ * ranges of integers (e.g. tensors) as raw bytes, tuples and Comparable types
+ * element-wise, pointers by their pointee, and anything else through its
+ * hash_value.
+ *
+ * Two independent 64-bit lanes are maintained, so that digest128 has the
+ * collision resistance of a 128-bit hash (for non-adversarial inputs), at
+ * twice the cost of a single lane. Digests are deterministic, and do not
+ * modify the state, so that updates can continue afterwards.
+ */
+
+struct hash128 {
+    uint64_t low;
+    uint64_t high;
+
+    constexpr auto operator<=>(hash128 const&) const = default;
+};
+
+template <>
+struct hash<hash128> {
+    constexpr size_t operator()(hash128 const& value) const {
+        return size_t(value.low ^ (value.high >> (64 - 8 * sizeof(size_t))));
+    }
+};
+
+class hasher {
+public:
+
+    explicit hasher(uint64_t seed = hash_basis) :
+        low(seed),
+        high(detail::wyhash_mix(seed ^ detail::wyhash_secret[2], detail::wyhash_secret[3])),
+        count(0)
+    {}
+
+    hasher& update_bytes(void const* data, size_t size) {
+        low = wyhash(data, size, low);
+        high = wyhash(data, size, high);
+        ++count;
+        return *this;
+    }
+
+    template <typename T>
+    hasher& update(T const& value) {
+        if constexpr (is_bytewise_hashable_v<T>)
+            return update_bytes(&value, sizeof(T));
+        else if constexpr (requires { std::tuple_size<T>::value; std::get<0>(value); } && !requires { value.data(); })
+            return std::apply([this](auto const&... values) -> hasher& { (update(values), ...); return *this; }, value);
+        else if constexpr (requires { value.get_identity_tuple(); })
+            return update(value.get_identity_tuple());
+        else if constexpr (std::is_pointer_v<T> || requires { *value; value.get(); })
+            return update(*value);
+        else if constexpr (requires { value.size(); requires is_bytewise_hashable_v<std::remove_cvref_t<decltype(*value.data())>>; })
+            return update_bytes(value.data(), value.size() * sizeof(*value.data()));
+        else
+            return update(uint64_t(hash_value(value)));
+    }
+
+    size_t digest() const {
+        uint64_t h = finalize(low);
+        if constexpr (sizeof(size_t) == 4)
+            return size_t(h ^ (h >> 32));
+        else
+            return size_t(h);
+    }
+
+    hash128 digest128() const {
+        return { finalize(low), finalize(high) };
+    }
+
+private:
+    uint64_t low;
+    uint64_t high;
+    uint64_t count;
+
+    // Mix in the number of updates, so that trailing empty records matter
+    uint64_t finalize(uint64_t lane) const {
+        return detail::wyhash_mix(lane ^ detail::wyhash_secret[0], count ^ detail::wyhash_secret[1]);
+    }
+};
+
+
 }
 
 
@@ -0,0 +1,380 @@
+#ifndef GAME_JSON_STREAM_HPP
+#define GAME_JSON_STREAM_HPP
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <nlohmann/json.hpp>
+
+#include "./memory.hpp"
+#include "./shape.hpp"
+#include "./tensor.hpp"
+
+
+namespace game {
+
+
+/*
+ * Streaming JSON parsing, based on nlohmann's SAX interface. Unlike from_json,
+ * no DOM is built: values are written directly into the tensor storage as
+ * they are read, hence memory usage does not depend on the size of the input
+ * beyond the resulting tensors.
+ *
+ * Inputs are anything accepted by nlohmann::json::sax_parse (e.g. strings,
+ * streams, iterator pairs). Malformed documents raise nlohmann::json exceptions,
+ * and unexpected shapes raise shape_error.
+ */
+
+
+namespace detail {
+
+[[noreturn]] inline void rethrow_json_error(nlohmann::json::exception const& error) {
+    if (auto e = dynamic_cast<nlohmann::json::parse_error const*>(&error))
+        throw *e;
+    if (auto e = dynamic_cast<nlohmann::json::out_of_range const*>(&error))
+        throw *e;
+    throw std::runtime_error(error.what());
+}
+
+}
+
+
+/*
+ * SAX handler for a nested array of numbers. Dimensions are inferred while
+ * parsing, from the length of the first array at each depth, and all other
+ * arrays must agree.
+ *
+ * Dynamic tensors grow as needed; fixed-size tensors and views are written in
+ * place, and must match the parsed shape exactly.
+ */
+template <typename Target>
+struct tensor_json_handler {
+
+    using value_type = std::remove_cvref_t<decltype(*std::declval<Target&>().data())>;
+    using shape_type = decltype(std::declval<Target&>().shape());
+
+    static constexpr unsigned N = Target::ndim;
+    static constexpr bool is_resizable = !std::is_empty_v<shape_type> && requires(Target& t) { t.reshape(t.shape()); };
+
+    Target& target;
+    std::array<dim_t, N> dims = {};
+    std::array<dim_t, N> counts = {};
+    std::array<bool, N> known = {};
+    unsigned depth = 0;
+    size_t count = 0;
+    bool started = false;
+
+    explicit tensor_json_handler(Target& target) : target(target) {
+        if constexpr (is_resizable)
+            target.storage.clear();
+    }
+
+    // Whether the outermost array has been closed
+    bool is_done() const {
+        return started && depth == 0;
+    }
+
+    // Check final shape, and resize dynamic tensors accordingly
+    void finish() {
+        if (!is_done())
+            throw shape_error();
+        // Dimensions below an empty array are unknown, use the static ones (or zero)
+        auto expected = is_resizable ? shape_type{}.to_array() : target.shape().to_array();
+        for (unsigned i = 0; i < N; ++i)
+            if (!known[i])
+                dims[i] = expected[i];
+        if constexpr (is_resizable) {
+            shape_type shape = {};
+            if (!shape.from_array(dims))
+                throw shape_error();
+            if (shape.product() != count)
+                throw shape_error();
+            target.reshape(shape);
+        }
+        else {
+            if (dims != expected || count != target.size())
+                throw shape_error();
+        }
+    }
+
+    bool start_array(size_t = size_t(-1)) {
+        if (is_done() || depth >= N)
+            throw shape_error();
+        if (depth > 0)
+            ++counts[depth - 1];
+        started = true;
+        counts[depth++] = 0;
+        return true;
+    }
+
+    bool end_array() {
+        --depth;
+        if (known[depth]) {
+            if (counts[depth] != dims[depth])
+                throw shape_error();
+        }
+        else {
+            dims[depth] = counts[depth];
+            known[depth] = true;
+        }
+        return true;
+    }
+
+    template <typename V>
+    bool value(V v) {
+        if (depth != N)
+            throw shape_error();
+        ++counts[N - 1];
+        if constexpr (is_resizable)
+            target.storage.push_back(static_cast<value_type>(v));
+        else {
+            if (count >= target.size())
+                throw shape_error();
+            target.data()[count] = static_cast<value_type>(v);
+        }
+        ++count;
+        return true;
+    }
+
+    bool boolean(bool v) {
+        return value(v);
+    }
+
+    bool number_integer(nlohmann::json::number_integer_t v) {
+        return value(v);
+    }
+
+    bool number_unsigned(nlohmann::json::number_unsigned_t v) {
+        return value(v);
+    }
+
+    bool number_float(nlohmann::json::number_float_t v, std::string const&) {
+        return value(v);
+    }
+
+    bool null() {
+        throw shape_error();
+    }
+
+    bool string(std::string&) {
+        throw shape_error();
+    }
+
+    bool binary(nlohmann::json::binary_t&) {
+        throw shape_error();
+    }
+
+    bool start_object(size_t) {
+        throw shape_error();
+    }
+
+    bool key(std::string&) {
+        throw shape_error();
+    }
+
+    bool end_object() {
+        throw shape_error();
+    }
+
+    bool parse_error(size_t, std::string const&, nlohmann::json::exception const& error) {
+        detail::rethrow_json_error(error);
+    }
+};
+
+
+template <typename Input, typename T, dim_t Head, dim_t... Tail>
+void parse_json(Input&& input, tensor<T, Head, Tail...>& value) {
+    tensor_json_handler<tensor<T, Head, Tail...>> handler(value);
+    nlohmann::json::sax_parse(std::forward<Input>(input), &handler);
+    handler.finish();
+}
+
+template <typename Input, typename T, dim_t Head, dim_t... Tail>
+void parse_json(Input&& input, view<T, Head, Tail...> value) {
+    tensor_json_handler<view<T, Head, Tail...>> handler(value);
+    nlohmann::json::sax_parse(std::forward<Input>(input), &handler);
+    handler.finish();
+}
+
+
+/*
+ * SAX handler for a state record, as produced by State::to_json, i.e. an
+ * object with "grid" and "player" keys. The grid is parsed directly into the
+ * board, and unknown keys are skipped.
+ */
+template <typename State>
+struct state_json_handler {
+
+    using Grid = std::remove_cvref_t<decltype(std::declval<State&>().board.grid)>;
+
+    State& state;
+    tensor_json_handler<Grid> grid;
+    enum { NONE, GRID, PLAYER, OTHER } current = NONE;
+    unsigned depth = 0;
+    bool has_grid = false;
+    bool has_player = false;
+
+    explicit state_json_handler(State& state) : state(state), grid(state.board.grid) {}
+
+    void finish() {
+        if (depth != 0 || !has_grid || !has_player)
+            throw std::runtime_error("invalid state record");
+        grid.finish();
+
+        // Derived board data (e.g. row occupancy in bounce) must be refreshed
+        if constexpr (requires { state.board.count_rows(); })
+            state.board.count_rows();
+        if constexpr (requires { state.update_moves(); })
+            state.update_moves();
+    }
+
+    // Forward events to the grid handler, while it is active
+    bool in_grid() const {
+        return current == GRID && depth == 1;
+    }
+
+    template <typename V>
+    bool value(V v) {
+        if (in_grid())
+            return grid.value(v);
+        if (depth == 1 && current == PLAYER) {
+            if (!std::in_range<decltype(state.player)>(v))
+                throw std::runtime_error("invalid player");
+            state.player = static_cast<decltype(state.player)>(v);
+            has_player = true;
+            return true;
+        }
+        return scalar();
+    }
+
+    bool scalar() {
+        if (depth == 0 || (depth == 1 && current != OTHER))
+            throw std::runtime_error("invalid state record");
+        return true;
+    }
+
+    bool boolean(bool) {
+        return scalar();
+    }
+
+    bool number_integer(nlohmann::json::number_integer_t v) {
+        return value(v);
+    }
+
+    bool number_unsigned(nlohmann::json::number_unsigned_t v) {
+        return value(v);
+    }
+
+    bool number_float(nlohmann::json::number_float_t v, std::string const&) {
+        if (in_grid())
+            return grid.value(v);
+        return scalar();
+    }
+
+    bool null() {
+        return scalar();
+    }
+
+    bool string(std::string&) {
+        return scalar();
+    }
+
+    bool binary(nlohmann::json::binary_t&) {
+        return scalar();
+    }
+
+    bool start_object(size_t) {
+        if (in_grid())
+            throw shape_error();
+        if (depth == 0 && (has_grid || has_player))
+            throw std::runtime_error("invalid state record");
+        if (depth == 1 && current != OTHER)
+            throw std::runtime_error("invalid state record");
+        ++depth;
+        return true;
+    }
+
+    bool key(std::string& k) {
+        if (depth == 1) {
+            if (k == "grid")
+                current = GRID;
+            else if (k == "player")
+                current = PLAYER;
+            else
+                current = OTHER;
+        }
+        return true;
+    }
+
+    bool end_object() {
+        --depth;
+        return true;
+    }
+
+    bool start_array(size_t size) {
+        if (in_grid()) {
+            if (grid.is_done())
+                throw std::runtime_error("invalid state record");
+            has_grid = true;
+            return grid.start_array(size);
+        }
+        if (depth == 0 || (depth == 1 && current != OTHER))
+            throw std::runtime_error("invalid state record");
+        ++depth;
+        return true;
+    }
+
+    bool end_array() {
+        if (in_grid())
+            return grid.end_array();
+        --depth;
+        return true;
+    }
+
+    bool parse_error(size_t, std::string const&, nlohmann::json::exception const& error) {
+        detail::rethrow_json_error(error);
+    }
+};
+
+
+template <typename State, typename Input>
+std::shared_ptr<State> parse_state_json(Input&& input, std::shared_ptr<typename State::Config> const& config) {
+    auto state = game::allocate_shared<State>(config);
+    state_json_handler<State> handler(*state);
+    nlohmann::json::sax_parse(std::forward<Input>(input), &handler);
+    handler.finish();
+    return state;
+}
+
+
+/*
+ * Read newline-delimited JSON state records, calling f on each state. Empty
+ * lines are ignored. Only one line is held in memory at a time. Returns the
+ * number of states.
+ */
+template <typename State, typename F>
+size_t for_each_state_ndjson(std::istream& input, std::shared_ptr<typename State::Config> const& config, F&& f) {
+    size_t count = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        f(parse_state_json<State>(line, config));
+        ++count;
+    }
+    return count;
+}
+
+
+}
+
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef GAME_MEMORY_HPP
+#define GAME_MEMORY_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+
+namespace game {
+
+
+/*
+ * Heap allocations made by dynamic tensors go through a memory resource, which
+ * is selected per thread. By default, this is std::pmr::get_default_resource().
+ *
+ * Game states and actions are also allocated from it (see allocate_shared),
+ * including grids small enough to be stored inline, whether they are created
+ * by the game, parsed (see parse_state_json) or interned (see state_pool).
+ * Other members (e.g. the move list of bounce states) still use the global
+ * heap.
+ *
+ * A memory_scope temporarily overrides the resource of the current thread, for
+ * instance to put the nodes of a search tree in a dedicated arena:
+ *
+ *   game::arena arena;
+ *   {
+ *       game::memory_scope scope(&arena);
+ *       ... build and destroy the tree ...
+ *   }
+ *   arena.reset();
+ *
+ * Destructors still run when the tree is destroyed, but deallocations are
+ * no-ops, and the memory is reclaimed at once by reset. Each allocation
+ * remembers the resource it came from, so it is safe to leave the scope before
+ * the objects are destroyed (but not to reset the arena).
+ */
+
+inline std::pmr::memory_resource*& current_memory_resource() noexcept {
+    thread_local std::pmr::memory_resource* resource = nullptr;
+    return resource;
+}
+
+inline std::pmr::memory_resource* get_memory_resource() noexcept {
+    std::pmr::memory_resource* resource = current_memory_resource();
+    return resource ? resource : std::pmr::get_default_resource();
+}
+
+/*
+ * Same as std::make_shared, but the object and its control block are allocated
+ * from the current memory resource.
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> allocate_shared(Args&&... args) {
+    return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(get_memory_resource()), std::forward<Args>(args)...);
+}
+
+
+struct memory_scope {
+
+    explicit memory_scope(std::pmr::memory_resource* resource) noexcept : previous(current_memory_resource()) {
+        current_memory_resource() = resource;
+    }
+
+    memory_scope(memory_scope const&) = delete;
+    memory_scope& operator=(memory_scope const&) = delete;
+
+    ~memory_scope() {
+        current_memory_resource() = previous;
+    }
+
+private:
+
+    std::pmr::memory_resource* previous;
+};
+
+
+/*
+ * A bump-pointer arena, where deallocation is a no-op. All memory is reclaimed
+ * at once by reset, which keeps the chunks for later use, or by release, which
+ * returns them upstream.
+ *
+ * This is not thread-safe; use one arena per thread.
+ */
+struct arena : std::pmr::memory_resource {
+
+    explicit arena(size_t chunk_size = size_t(1) << 16, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+        chunk_size(chunk_size),
+        upstream(upstream)
+    {}
+
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+
+    ~arena() {
+        release();
+    }
+
+    void reset() noexcept {
+        current = head;
+        if (current) {
+            cursor = current->begin();
+            limit = current->end();
+        }
+        else
+            cursor = limit = nullptr;
+    }
+
+    void release() noexcept {
+        while (head) {
+            Chunk* next = head->next;
+            upstream->deallocate(head, sizeof(Chunk) + head->size, alignof(Chunk));
+            head = next;
+        }
+        current = nullptr;
+        cursor = limit = nullptr;
+    }
+
+    size_t get_capacity() const noexcept {
+        size_t capacity = 0;
+        for (Chunk* chunk = head; chunk; chunk = chunk->next)
+            capacity += chunk->size;
+        return capacity;
+    }
+
+private:
+
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        size_t size;
+
+        std::byte* begin() noexcept {
+            return reinterpret_cast<std::byte*>(this + 1);
+        }
+
+        std::byte* end() noexcept {
+            return begin() + size;
+        }
+    };
+
+    size_t chunk_size;
+    std::pmr::memory_resource* upstream;
+    Chunk* head = nullptr;
+    Chunk* current = nullptr;
+    std::byte* cursor = nullptr;
+    std::byte* limit = nullptr;
+
+    static std::byte* align(std::byte* pointer, size_t alignment) noexcept {
+        uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+        return pointer + ((alignment - value % alignment) % alignment);
+    }
+
+    bool fits(size_t bytes, size_t alignment) const noexcept {
+        return cursor && align(cursor, alignment) + bytes <= limit;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+
+        // Look for a large enough chunk, among the ones left from a previous reset
+        while (!fits(bytes, alignment) && current && current->next) {
+            current = current->next;
+            cursor = current->begin();
+            limit = current->end();
+        }
+
+        // Otherwise, append a new chunk
+        if (!fits(bytes, alignment)) {
+            size_t size = std::max(chunk_size, bytes + alignment);
+            Chunk* chunk = static_cast<Chunk*>(upstream->allocate(sizeof(Chunk) + size, alignof(Chunk)));
+            chunk->next = nullptr;
+            chunk->size = size;
+            if (current)
+                current->next = chunk;
+            else
+                head = chunk;
+            current = chunk;
+            cursor = chunk->begin();
+            limit = chunk->end();
+        }
+
+        std::byte* result = align(cursor, alignment);
+        cursor = result + bytes;
+        return result;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+
+}
+
+
+#endif
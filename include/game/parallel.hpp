@@ -0,0 +1,49 @@
+#ifndef GAME_PARALLEL_HPP
+#define GAME_PARALLEL_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+namespace game {
+
+
+/*
+ * Run f(i) for each i in [0, count), split in contiguous chunks over up to
+ * num_threads threads (including the calling one). With a single thread, this
+ * is a plain loop, without any synchronization.
+ *
+ * The function must not throw, and must be safe to call concurrently for
+ * different indices.
+ */
+template <typename F>
+void parallel_for(size_t count, unsigned num_threads, F const& f) {
+    size_t n = std::min<size_t>(std::max(num_threads, 1u), count);
+    if (n <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            f(i);
+        return;
+    }
+    size_t chunk = (count + n - 1) / n;
+    auto run = [&](size_t begin) {
+        size_t end = std::min(begin + chunk, count);
+        for (size_t i = begin; i < end; ++i)
+            f(i);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(n - 1);
+    for (size_t t = 1; t < n; ++t)
+        threads.emplace_back(run, t * chunk);
+    run(0);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+
+}
+
+
+#endif
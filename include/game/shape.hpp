@@ -265,6 +265,31 @@ constexpr bool operator==(shape_t<L...> const& left, shape_t<R...> const& right)
 }
 
 
+/*
+ * Multi-index helpers, for row-major storage. The offset is computed as
+ * ((i * d1 + j) * d2 + k)..., i.e. one multiply-add per dimension, where
+ * static dimensions are known at compile-time.
+ */
+
+template <dim_t... N>
+constexpr bool in_bounds(shape_t<N...> const& shape, std::array<dim_t, sizeof...(N)> const& index) {
+    auto dims = shape.to_array();
+    for (size_t i = 0; i < sizeof...(N); ++i)
+        if (index[i] < 0 || index[i] >= dims[i])
+            return false;
+    return true;
+}
+
+template <dim_t... N>
+constexpr size_t flat_index(shape_t<N...> const& shape, std::array<dim_t, sizeof...(N)> const& index) {
+    auto dims = shape.to_array();
+    size_t offset = 0;
+    for (size_t i = 0; i < sizeof...(N); ++i)
+        offset = offset * dims[i] + index[i];
+    return offset;
+}
+
+
 template <dim_t... N>
 struct hash<shape_t<N...>> {
     constexpr size_t operator()(shape_t<N...> const& value) const {
@@ -0,0 +1,176 @@
+#ifndef GAME_SIMD_HPP
+#define GAME_SIMD_HPP
+
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define GAME_SIMD_SSE2 1
+#include <immintrin.h>
+#endif
+
+// With GCC and Clang, AVX2 is selected at runtime, unless enabled at compile-time
+#if defined(GAME_SIMD_SSE2) && !defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+#define GAME_SIMD_AVX2_RUNTIME 1
+#define GAME_SIMD_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#define GAME_SIMD_AVX2_TARGET
+#endif
+
+
+namespace game {
+namespace simd {
+
+
+/*
+ * Kernels for contiguous ranges of plain values, used by tensor comparison and
+ * filling. Each kernel has a scalar fallback, an SSE2 path, and an AVX2 path,
+ * which is either enabled at compile-time (e.g. -mavx2) or detected at runtime.
+ */
+
+
+/*
+ * Index of the first differing byte, or size if both ranges are equal.
+ */
+
+inline size_t mismatch_scalar(unsigned char const* a, unsigned char const* b, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if (x != y) {
+            uint64_t d = x ^ y;
+            if constexpr (std::endian::native == std::endian::little)
+                return i + std::countr_zero(d) / 8;
+            else
+                return i + std::countl_zero(d) / 8;
+        }
+    }
+    for (; i < size; ++i)
+        if (a[i] != b[i])
+            return i;
+    return size;
+}
+
+#ifdef GAME_SIMD_SSE2
+
+inline size_t mismatch_sse2(unsigned char const* a, unsigned char const* b, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffff;
+        if (mask)
+            return i + std::countr_zero(mask);
+    }
+    return i + mismatch_scalar(a + i, b + i, size - i);
+}
+
+#endif
+
+#ifdef GAME_SIMD_AVX2_TARGET
+
+GAME_SIMD_AVX2_TARGET inline size_t mismatch_avx2(unsigned char const* a, unsigned char const* b, size_t size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+        unsigned mask = ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (mask)
+            return i + std::countr_zero(mask);
+    }
+    return i + mismatch_sse2(a + i, b + i, size - i);
+}
+
+inline bool has_avx2() {
+#if defined(__AVX2__)
+    return true;
+#else
+    static bool const result = __builtin_cpu_supports("avx2");
+    return result;
+#endif
+}
+
+#endif
+
+inline size_t mismatch(void const* a, void const* b, size_t size) {
+    auto x = static_cast<unsigned char const*>(a);
+    auto y = static_cast<unsigned char const*>(b);
+#if defined(GAME_SIMD_AVX2_TARGET)
+    if (has_avx2())
+        return mismatch_avx2(x, y, size);
+    return mismatch_sse2(x, y, size);
+#elif defined(GAME_SIMD_SSE2)
+    return mismatch_sse2(x, y, size);
+#else
+    return mismatch_scalar(x, y, size);
+#endif
+}
+
+
+/*
+ * Bytewise comparison is only valid when the value is fully determined by its
+ * bytes, which excludes floating-point numbers (e.g. NaN, signed zero).
+ */
+template <typename T>
+inline constexpr bool is_bitwise_comparable_v = std::has_unique_object_representations_v<T>;
+
+
+template <typename T>
+constexpr bool equal(T const* a, T const* b, size_t size) {
+    if constexpr (is_bitwise_comparable_v<T>) {
+        if (!std::is_constant_evaluated())
+            return size == 0 || std::memcmp(a, b, size * sizeof(T)) == 0;
+    }
+    return std::equal(a, a + size, b);
+}
+
+
+template <typename T>
+constexpr auto compare_three_way(T const* a, size_t a_size, T const* b, size_t b_size) {
+    if constexpr (std::is_integral_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            size_t size = std::min(a_size, b_size);
+            size_t index = mismatch(a, b, size * sizeof(T)) / sizeof(T);
+            if (index < size)
+                return a[index] <=> b[index];
+            return a_size <=> b_size;
+        }
+    }
+    return std::lexicographical_compare_three_way(a, a + a_size, b, b + b_size);
+}
+
+
+/*
+ * Filling is delegated to memset, when all bytes of the value are identical
+ * (e.g. 0 or -1).
+ */
+template <typename T>
+constexpr void fill(T* pointer, size_t size, T const& value) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (!std::is_constant_evaluated()) {
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+            if (std::all_of(bytes, bytes + sizeof(T), [&](unsigned char b) { return b == bytes[0]; })) {
+                if (size > 0)
+                    std::memset(pointer, bytes[0], size * sizeof(T));
+                return;
+            }
+        }
+    }
+    std::fill_n(pointer, size, value);
+}
+
+
+}
+}
+
+
+#endif
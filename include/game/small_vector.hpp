@@ -0,0 +1,260 @@
+#ifndef GAME_SMALL_VECTOR_HPP
+#define GAME_SMALL_VECTOR_HPP
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "./hash.hpp"
+#include "./memory.hpp"
+
+
+namespace game {
+
+
+/*
+ * A vector-like storage, where up to N elements are stored inline, without any
+ * heap allocation. Larger sizes fall back to the heap.
+ *
+ * Heap memory comes from the memory resource of the current thread at the time
+ * of the first heap allocation (see memory_scope), and is returned to it.
+ *
+ * Only the subset of the std::vector interface needed by tensors is provided.
+ * Note that, unlike std::vector, moving an inline storage moves each element,
+ * hence pointers are invalidated.
+ */
+template <typename T, size_t N>
+struct small_vector {
+
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = T const*;
+
+    static constexpr size_t inline_capacity = N;
+
+    small_vector() noexcept : pointer(inline_data()), count(0), capacity_(N) {}
+
+    explicit small_vector(size_t size) : small_vector() {
+        resize(size);
+    }
+
+    small_vector(std::initializer_list<T> list) : small_vector(list.begin(), list.end()) {}
+
+    template <typename Allocator>
+    small_vector(std::vector<T, Allocator> const& other) : small_vector(other.data(), other.data() + other.size()) {}
+
+    template <typename It>
+        requires (!std::is_integral_v<It>)
+    small_vector(It first, It last) : small_vector() {
+        reserve(std::distance(first, last));
+        for (; first != last; ++first)
+            new (pointer + count++) T(*first);
+    }
+
+    small_vector(small_vector const& other) : small_vector(other.begin(), other.end()) {}
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : small_vector() {
+        steal(other);
+    }
+
+    ~small_vector() {
+        clear();
+        deallocate();
+    }
+
+    small_vector& operator=(small_vector const& other) {
+        if (this != &other) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                clear();
+                reserve(other.count);
+                std::memcpy(pointer, other.pointer, other.count * sizeof(T));
+                count = other.count;
+            }
+            else {
+                small_vector copy(other);
+                clear();
+                deallocate();
+                steal(copy);
+            }
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        if (this != &other) {
+            clear();
+            deallocate();
+            steal(other);
+        }
+        return *this;
+    }
+
+    T* data() noexcept {
+        return pointer;
+    }
+
+    T const* data() const noexcept {
+        return pointer;
+    }
+
+    size_t size() const noexcept {
+        return count;
+    }
+
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    bool empty() const noexcept {
+        return count == 0;
+    }
+
+    bool is_inline() const noexcept {
+        return pointer == inline_data();
+    }
+
+    T* begin() noexcept {
+        return pointer;
+    }
+
+    T const* begin() const noexcept {
+        return pointer;
+    }
+
+    T* end() noexcept {
+        return pointer + count;
+    }
+
+    T const* end() const noexcept {
+        return pointer + count;
+    }
+
+    T& operator[](size_t index) {
+        return pointer[index];
+    }
+
+    T const& operator[](size_t index) const {
+        return pointer[index];
+    }
+
+    void reserve(size_t size) {
+        if (size <= capacity_)
+            return;
+        std::pmr::memory_resource* target_resource = is_inline() ? get_memory_resource() : resource;
+        T* target = static_cast<T*>(target_resource->allocate(size * sizeof(T), alignof(T)));
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (count > 0)
+                std::memcpy(target, pointer, count * sizeof(T));
+        }
+        else {
+            std::uninitialized_move_n(pointer, count, target);
+            std::destroy_n(pointer, count);
+        }
+        deallocate();
+        pointer = target;
+        capacity_ = size;
+        resource = target_resource;
+    }
+
+    void resize(size_t size) {
+        if (size > count) {
+            reserve(size);
+            std::uninitialized_value_construct_n(pointer + count, size - count);
+        }
+        else
+            std::destroy_n(pointer + size, count - size);
+        count = size;
+    }
+
+    void clear() noexcept {
+        std::destroy_n(pointer, count);
+        count = 0;
+    }
+
+    void push_back(T const& value) {
+        if (count == capacity_)
+            reserve(std::max<size_t>(2 * capacity_, 1));
+        new (pointer + count++) T(value);
+    }
+
+private:
+
+    T* pointer;
+    size_t count;
+    size_t capacity_;
+    std::pmr::memory_resource* resource = nullptr;
+    alignas(T) std::byte buffer[N > 0 ? N * sizeof(T) : 1];
+
+    T* inline_data() noexcept {
+        return std::launder(reinterpret_cast<T*>(buffer));
+    }
+
+    T const* inline_data() const noexcept {
+        return std::launder(reinterpret_cast<T const*>(buffer));
+    }
+
+    void deallocate() noexcept {
+        if (!is_inline()) {
+            resource->deallocate(pointer, capacity_ * sizeof(T), alignof(T));
+            pointer = inline_data();
+            capacity_ = N;
+        }
+    }
+
+    // Assumes that this storage is empty and inline
+    void steal(small_vector& other) {
+        if (other.is_inline()) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                if (other.count > 0)
+                    std::memcpy(pointer, other.pointer, other.count * sizeof(T));
+            }
+            else
+                std::uninitialized_move_n(other.pointer, other.count, pointer);
+            count = other.count;
+            other.clear();
+        }
+        else {
+            pointer = other.pointer;
+            count = other.count;
+            capacity_ = other.capacity_;
+            resource = other.resource;
+            other.pointer = other.inline_data();
+            other.count = 0;
+            other.capacity_ = N;
+        }
+    }
+};
+
+
+template <typename T, size_t N, size_t M>
+bool operator==(small_vector<T, N> const& left, small_vector<T, M> const& right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end());
+}
+
+template <typename T, size_t N, typename Allocator>
+bool operator==(small_vector<T, N> const& left, std::vector<T, Allocator> const& right) {
+    return std::equal(left.begin(), left.end(), right.begin(), right.end());
+}
+
+
+template <typename T, size_t N>
+struct hash<small_vector<T, N>> {
+    size_t operator()(small_vector<T, N> const& value) const {
+        return hash_range(value);
+    }
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef GAME_STATE_POOL_HPP
+#define GAME_STATE_POOL_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./hash.hpp"
+#include "./memory.hpp"
+
+
+namespace game {
+
+
+/*
+ * Interning (a.k.a. hash-consing) of states, so that replay buffers and search
+ * graphs hold a single copy of each distinct position. Equal states, in the
+ * sense of Comparable (i.e. same game::hash and identity tuple), are mapped to
+ * the same small integer id, hence comparing ids replaces deep equality.
+ *
+ * Each id is reference-counted; when its count drops to zero, the state is
+ * evicted and the id may be reused. Pooled states are shared, and must not be
+ * modified in place.
+ *
+ * All methods are thread-safe. Lookups by id take no lock, while interning and
+ * reference counting lock one of several shards, selected by hash.
+ */
+template <typename State>
+class state_pool {
+public:
+
+    using id_type = uint32_t;
+
+    class handle;
+
+    explicit state_pool(unsigned num_shards = 64) :
+        shards(std::bit_ceil(std::max(num_shards, 1u)))
+    {}
+
+    state_pool(state_pool const&) = delete;
+    state_pool& operator=(state_pool const&) = delete;
+
+    ~state_pool() {
+        for (auto& chunk : chunks)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    // Get the id of an equal state, or store this one, and add a reference
+    id_type intern(std::shared_ptr<State> const& state) {
+        return intern(*state, [&] { return state; });
+    }
+
+    // Same, but a copy is stored, if needed
+    id_type intern(State const& state) {
+        return intern(state, [&] { return game::allocate_shared<State>(state); });
+    }
+
+    // Same, but the reference is owned by the returned handle
+    template <typename S>
+    handle acquire(S const& state) {
+        return handle(this, intern(state));
+    }
+
+    void retain(id_type id) {
+        Slot& slot = get_slot(id);
+        std::lock_guard lock(shards[slot.shard].mutex);
+        ++slot.count;
+    }
+
+    void release(id_type id) {
+        Slot& slot = get_slot(id);
+        Shard& shard = shards[slot.shard];
+        std::shared_ptr<State> evicted;
+        {
+            std::lock_guard lock(shard.mutex);
+            if (--slot.count > 0)
+                return;
+            shard.ids.erase(slot.state.get());
+            evicted = std::move(slot.state);
+        }
+        {
+            std::lock_guard lock(allocation_mutex);
+            free_ids.push_back(id);
+        }
+        num_states.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // The id must be referenced (i.e. not evicted)
+    std::shared_ptr<State> const& get(id_type id) const {
+        return get_slot(id).state;
+    }
+
+    State const& operator[](id_type id) const {
+        return *get(id);
+    }
+
+    unsigned use_count(id_type id) const {
+        Slot const& slot = get_slot(id);
+        std::lock_guard lock(shards[slot.shard].mutex);
+        return slot.count;
+    }
+
+    // Number of distinct states currently stored
+    size_t size() const {
+        return num_states.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    struct Slot {
+        std::shared_ptr<State> state;
+        unsigned count = 0;
+        unsigned shard = 0;
+    };
+
+    struct pointer_hash {
+        size_t operator()(State const* state) const {
+            return hash_value(*state);
+        }
+    };
+
+    struct pointer_equal {
+        bool operator()(State const* left, State const* right) const {
+            return *left == *right;
+        }
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<State const*, id_type, pointer_hash, pointer_equal> ids;
+    };
+
+    /*
+     * Slots are allocated in chunks of doubling size, which are never moved,
+     * so that lookups do not need any lock: chunk k holds ids in
+     * [B (2^k - 1), B (2^(k+1) - 1)).
+     */
+    static constexpr size_t base_chunk_size = 64;
+    static constexpr unsigned max_chunks = 32;
+
+    std::vector<Shard> shards;
+    std::array<std::atomic<Slot*>, max_chunks> chunks = {};
+    std::mutex allocation_mutex;
+    std::vector<id_type> free_ids;
+    id_type next_id = 0;
+    std::atomic<size_t> num_states = 0;
+
+    static std::pair<unsigned, size_t> locate(id_type id) {
+        size_t q = id / base_chunk_size + 1;
+        unsigned k = std::bit_width(q) - 1;
+        return { k, id - base_chunk_size * ((size_t(1) << k) - 1) };
+    }
+
+    Slot& get_slot(id_type id) const {
+        auto [k, offset] = locate(id);
+        return chunks[k].load(std::memory_order_acquire)[offset];
+    }
+
+    id_type allocate() {
+        std::lock_guard lock(allocation_mutex);
+        if (!free_ids.empty()) {
+            id_type id = free_ids.back();
+            free_ids.pop_back();
+            return id;
+        }
+        if (next_id == std::numeric_limits<id_type>::max())
+            throw std::length_error("state pool is full");
+        id_type id = next_id++;
+        auto [k, offset] = locate(id);
+        if (offset == 0)
+            chunks[k].store(new Slot[base_chunk_size << k], std::memory_order_release);
+        return id;
+    }
+
+    template <typename F>
+    id_type intern(State const& state, F&& make) {
+        size_t hash = hash_value(state);
+        unsigned shard_index = (hash ^ (hash >> (4 * sizeof(size_t)))) & (shards.size() - 1);
+        Shard& shard = shards[shard_index];
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.ids.find(&state);
+        if (it != shard.ids.end()) {
+            ++get_slot(it->second).count;
+            return it->second;
+        }
+        id_type id = allocate();
+        Slot& slot = get_slot(id);
+        slot.state = make();
+        slot.count = 1;
+        slot.shard = shard_index;
+        shard.ids.emplace(slot.state.get(), id);
+        num_states.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+};
+
+
+/*
+ * Owning reference to a pooled state, which behaves like a shared pointer.
+ * Handles of the same pool are equal if and only if their states are.
+ */
+template <typename State>
+class state_pool<State>::handle {
+public:
+
+    handle() = default;
+
+    handle(handle const& other) : pool(other.pool), id_(other.id_) {
+        if (pool)
+            pool->retain(id_);
+    }
+
+    handle(handle&& other) noexcept : pool(std::exchange(other.pool, nullptr)), id_(other.id_) {}
+
+    handle& operator=(handle other) noexcept {
+        std::swap(pool, other.pool);
+        std::swap(id_, other.id_);
+        return *this;
+    }
+
+    ~handle() {
+        if (pool)
+            pool->release(id_);
+    }
+
+    explicit operator bool() const {
+        return pool != nullptr;
+    }
+
+    id_type id() const {
+        return id_;
+    }
+
+    std::shared_ptr<State> const& get() const {
+        return pool->get(id_);
+    }
+
+    State const& operator*() const {
+        return *get();
+    }
+
+    State const* operator->() const {
+        return get().get();
+    }
+
+    bool operator==(handle const& right) const {
+        return pool == right.pool && (!pool || id_ == right.id_);
+    }
+
+private:
+
+    friend state_pool;
+
+    // Adopt an existing reference
+    handle(state_pool* pool, id_type id) : pool(pool), id_(id) {}
+
+    state_pool* pool = nullptr;
+    id_type id_ = 0;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef GAME_STRIDED_VIEW_HPP
+#define GAME_STRIDED_VIEW_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "./shape.hpp"
+#include "./tensor.hpp"
+
+
+namespace game {
+
+
+/*
+ * A view with arbitrary (possibly negative) strides, expressed in elements.
+ * This allows slicing, flipping and transposing a tensor without any copy, for
+ * instance to swap the perspective of a board.
+ *
+ * As strides are only known at runtime, the shape is always dynamic. Use
+ * copy_to or as_tensor to get back a dense storage.
+ */
+template <typename T, unsigned N>
+struct strided_view {
+
+    static_assert(N > 0);
+
+    static constexpr unsigned ndim = N;
+
+    T* pointer;
+    std::array<dim_t, N> shape_;
+    std::array<ptrdiff_t, N> strides_;
+
+    constexpr strided_view(T* pointer, std::array<dim_t, N> const& shape, std::array<ptrdiff_t, N> const& strides) :
+        pointer(pointer),
+        shape_(shape),
+        strides_(strides)
+    {}
+
+    template <dim_t... D>
+        requires (sizeof...(D) == N)
+    constexpr strided_view(view<T, D...> const& value) : pointer(value.pointer), shape_(value.shape().to_array()) {
+        ptrdiff_t stride = 1;
+        for (unsigned i = N; i-- > 0;) {
+            strides_[i] = stride;
+            stride *= shape_[i];
+        }
+    }
+
+    template <typename U>
+        requires (std::is_same_v<T, U const>)
+    constexpr strided_view(strided_view<U, N> const& other) :
+        pointer(other.pointer),
+        shape_(other.shape_),
+        strides_(other.strides_)
+    {}
+
+    constexpr T* data() const noexcept {
+        return pointer;
+    }
+
+    constexpr std::array<dim_t, N> const& shape() const noexcept {
+        return shape_;
+    }
+
+    constexpr std::array<ptrdiff_t, N> const& strides() const noexcept {
+        return strides_;
+    }
+
+    constexpr size_t size() const noexcept {
+        size_t result = 1;
+        for (dim_t d : shape_)
+            result *= d;
+        return result;
+    }
+
+    // Whether elements are stored densely, in row-major order
+    constexpr bool is_contiguous() const noexcept {
+        ptrdiff_t stride = 1;
+        for (unsigned i = N; i-- > 0;) {
+            if (shape_[i] != 1 && strides_[i] != stride)
+                return false;
+            stride *= shape_[i];
+        }
+        return true;
+    }
+
+    constexpr decltype(auto) operator[](dim_t index) const {
+        if constexpr (N == 1) {
+            return pointer[index * strides_[0]];
+        }
+        else {
+            std::array<dim_t, N - 1> shape;
+            std::array<ptrdiff_t, N - 1> strides;
+            std::copy_n(shape_.begin() + 1, N - 1, shape.begin());
+            std::copy_n(strides_.begin() + 1, N - 1, strides.begin());
+            return strided_view<T, N - 1>(pointer + index * strides_[0], shape, strides);
+        }
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == N)
+    constexpr T& operator()(I... indices) const {
+        std::array<dim_t, N> index = { dim_t(indices)... };
+        ptrdiff_t offset = 0;
+        for (unsigned i = 0; i < N; ++i)
+            offset += index[i] * strides_[i];
+        return pointer[offset];
+    }
+
+    constexpr strided_view slice(unsigned dim, dim_t begin, dim_t end) const {
+        if (dim >= N || begin < 0 || begin > end || end > shape_[dim])
+            throw shape_error();
+        strided_view result = *this;
+        result.pointer += begin * strides_[dim];
+        result.shape_[dim] = end - begin;
+        return result;
+    }
+
+    constexpr strided_view flip(unsigned dim) const {
+        if (dim >= N)
+            throw shape_error();
+        strided_view result = *this;
+        if (shape_[dim] > 0)
+            result.pointer += (shape_[dim] - 1) * strides_[dim];
+        result.strides_[dim] = -strides_[dim];
+        return result;
+    }
+
+    constexpr strided_view transpose(unsigned a, unsigned b) const {
+        if (a >= N || b >= N)
+            throw shape_error();
+        strided_view result = *this;
+        std::swap(result.shape_[a], result.shape_[b]);
+        std::swap(result.strides_[a], result.strides_[b]);
+        return result;
+    }
+
+    // Reverse the order of all dimensions
+    constexpr strided_view transpose() const {
+        strided_view result = *this;
+        std::reverse(result.shape_.begin(), result.shape_.end());
+        std::reverse(result.strides_.begin(), result.strides_.end());
+        return result;
+    }
+
+    template <typename U, dim_t... D>
+        requires (sizeof...(D) == N)
+    constexpr void copy_to(view<U, D...> destination) const {
+        if (destination.shape().to_array() != shape_)
+            throw shape_error();
+        if (is_contiguous())
+            std::copy_n(pointer, size(), destination.data());
+        else
+            copy_rows(0, pointer, destination.data());
+    }
+
+    template <typename U, dim_t... D>
+        requires (sizeof...(D) == N)
+    constexpr void copy_to(tensor<U, D...>& destination) const {
+        copy_to(destination.as_view());
+    }
+
+    constexpr auto as_tensor() const {
+        return as_tensor_impl(std::make_index_sequence<N>());
+    }
+
+private:
+
+    template <size_t... I>
+    constexpr auto as_tensor_impl(std::index_sequence<I...>) const {
+        tensor<std::remove_const_t<T>, (void(I), -1)...> result(shape_[I]...);
+        copy_to(result);
+        return result;
+    }
+
+    template <typename U>
+    constexpr U* copy_rows(unsigned dim, T* source, U* target) const {
+        dim_t n = shape_[dim];
+        ptrdiff_t stride = strides_[dim];
+        if (dim + 1 == N) {
+            if (stride == 1)
+                return std::copy_n(source, n, target);
+            for (dim_t i = 0; i < n; ++i, source += stride)
+                *target++ = *source;
+            return target;
+        }
+        for (dim_t i = 0; i < n; ++i, source += stride)
+            target = copy_rows(dim + 1, source, target);
+        return target;
+    }
+};
+
+
+template <typename T, dim_t Head, dim_t... Tail>
+constexpr strided_view<T, 1 + sizeof...(Tail)> as_strided(view<T, Head, Tail...> const& value) {
+    return value;
+}
+
+template <typename T, dim_t Head, dim_t... Tail>
+constexpr strided_view<T, 1 + sizeof...(Tail)> as_strided(tensor<T, Head, Tail...>& value) {
+    return value.as_view();
+}
+
+template <typename T, dim_t Head, dim_t... Tail>
+constexpr strided_view<T const, 1 + sizeof...(Tail)> as_strided(tensor<T, Head, Tail...> const& value) {
+    return value.as_view();
+}
+
+
+}
+
+
+#endif
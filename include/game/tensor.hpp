@@ -5,12 +5,19 @@
 #include <algorithm>
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
+#include "./parallel.hpp"
 #include "./shape.hpp"
+#include "./simd.hpp"
+#include "./small_vector.hpp"
 
 
 namespace game {
@@ -24,7 +31,7 @@ namespace game {
  * supported, using the placeholder size value -1 for one or more dimensions.
  *
  * Note that stride and other forms of non-dense storage are out-of-scope of
- * this implementation.
+ * this implementation; see strided_view for zero-copy slicing and transposition.
  */
 template <typename T, dim_t Head, dim_t... Tail>
 struct tensor;
@@ -41,6 +48,64 @@ template <typename T, dim_t Head, dim_t... Tail>
 struct view;
 
 
+/*
+ * Dynamic-shaped tensors store up to GAME_TENSOR_INLINE_BYTES bytes inline, so
+ * that small tensors (e.g. game grids) can be copied without heap allocation.
+ * Types that are not trivially copyable are always stored on the heap.
+ */
+#ifndef GAME_TENSOR_INLINE_BYTES
+#define GAME_TENSOR_INLINE_BYTES 64
+#endif
+
+template <typename T>
+using dynamic_storage = small_vector<T, std::is_trivially_copyable_v<T> ? GAME_TENSOR_INLINE_BYTES / sizeof(T) : 0>;
+
+
+/*
+ * Lazy elementwise expressions, see expression.hpp. Tensors and views can be
+ * assigned from them.
+ */
+template <typename Op, typename... Args>
+struct expression;
+
+template <typename E>
+inline constexpr bool is_expression_v = false;
+
+template <typename Op, typename... Args>
+inline constexpr bool is_expression_v<expression<Op, Args...>> = true;
+
+
+/*
+ * Element access. operator[] and operator() are unchecked, unless
+ * GAME_TENSOR_CHECKED is defined (e.g. in debug builds), in which case they
+ * throw std::out_of_range like at().
+ */
+#ifdef GAME_TENSOR_CHECKED
+#define GAME_TENSOR_CHECK(condition) ((condition) ? void(0) : throw std::out_of_range("tensor index out of range"))
+#else
+#define GAME_TENSOR_CHECK(condition) void(0)
+#endif
+
+namespace detail {
+
+template <dim_t... D, typename... I>
+constexpr size_t offset(shape_t<D...> const& shape, I... indices) {
+    std::array<dim_t, sizeof...(D)> index = { dim_t(indices)... };
+    GAME_TENSOR_CHECK(in_bounds(shape, index));
+    return flat_index(shape, index);
+}
+
+template <dim_t... D, typename... I>
+constexpr size_t checked_offset(shape_t<D...> const& shape, I... indices) {
+    std::array<dim_t, sizeof...(D)> index = { dim_t(indices)... };
+    if (!in_bounds(shape, index))
+        throw std::out_of_range("tensor index out of range");
+    return flat_index(shape, index);
+}
+
+}
+
+
 // TODO should maybe define begin() and end(), which are slice iterators, and change the semantics of data() and size()?
 
 
@@ -84,17 +149,45 @@ struct tensor {
     constexpr void reshape(shape_t<Head, Tail...> const&) {}
 
     constexpr view<T, Tail...> operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && index < Head);
         return view<T, Tail...>(storage.data() + index * (Tail * ...));
     }
 
     constexpr view<T const, Tail...> operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && index < Head);
         return view<T const, Tail...>(storage.data() + index * (Tail * ...));
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
 
-    // TODO operator=
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr tensor& operator=(E const& e) {
+        assign(as_view(), e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
         storage.fill(value);
@@ -125,7 +218,7 @@ struct tensor<T, Head, Tail...> {
     static constexpr unsigned ndim = 1 + sizeof...(Tail);
     static constexpr unsigned nddim = ((Head < 0) + ... + (Tail < 0));
 
-    std::vector<T> storage;
+    dynamic_storage<T> storage;
     shape_t<Head, Tail...> shape_;
 
     constexpr tensor() : shape_{ 0 } {}
@@ -159,20 +252,48 @@ struct tensor<T, Head, Tail...> {
     }
 
     constexpr view<T, Tail...> operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && index < shape_.head());
         return { data() + index * shape_.tail().product(), shape_.tail()};
     }
 
     constexpr view<T const, Tail...> operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && index < shape_.head());
         return { data() + index * shape_.tail().product(), shape_.tail()};
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return storage.data()[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return storage.data()[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return storage.data()[detail::checked_offset(shape_, indices...)];
+    }
 
-    // TODO =
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return storage.data()[detail::checked_offset(shape_, indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr tensor& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(storage.data(), storage.size(), value);
+        simd::fill(storage.data(), storage.size(), value);
     }
 
     constexpr tensor<T, Head, Tail...> const& as_tensor() const {
@@ -230,17 +351,45 @@ struct tensor<T, Head> {
     constexpr void reshape(shape_t<Head> const&) {}
 
     constexpr T& operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return storage[index];
     }
 
     constexpr T const& operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return storage[index];
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
 
-    // TODO =
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr tensor& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
         storage.fill(value);
@@ -269,7 +418,7 @@ struct tensor<T, -1> {
     static constexpr unsigned ndim = 1;
     static constexpr unsigned nddim = 1;
 
-    std::vector<T> storage;
+    dynamic_storage<T> storage;
 
     constexpr tensor() = default;
 
@@ -300,20 +449,48 @@ struct tensor<T, -1> {
     }
 
     constexpr T& operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return storage[index];
     }
 
     constexpr T const& operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return storage[index];
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
 
-    // TODO =
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return storage.data()[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return storage.data()[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr tensor& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(storage.data(), storage.size(), value);
+        simd::fill(storage.data(), storage.size(), value);
     }
 
     constexpr tensor<T, -1> const& as_tensor() const {
@@ -362,20 +539,48 @@ struct view {
     }
 
     constexpr view<T, Tail...> operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && index < Head);
         return view<T, Tail...>(pointer + index * (Tail * ...));
     }
 
     constexpr view<T const, Tail...> operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && index < Head);
         return view<T const, Tail...>(pointer + index * (Tail * ...));
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return pointer[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return pointer[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return pointer[detail::checked_offset(shape(), indices...)];
+    }
 
-    // TODO =
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return pointer[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr view& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(pointer, size(), value);
+        simd::fill(pointer, size(), value);
     }
 
     constexpr tensor<T, Head, Tail...> as_tensor() const {
@@ -429,20 +634,48 @@ struct view<T, Head, Tail...> {
     }
 
     constexpr view<T, Tail...> operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && index < shape_.head());
         return { pointer + index * shape_.tail().product(), shape_.tail() };
     }
 
     constexpr view<T const, Tail...> operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && index < shape_.head());
         return { pointer + index * shape_.tail().product(), shape_.tail() };
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return pointer[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return pointer[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return pointer[detail::checked_offset(shape_, indices...)];
+    }
 
-    // TODO =
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return pointer[detail::checked_offset(shape_, indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr view& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(pointer, size(), value);
+        simd::fill(pointer, size(), value);
     }
 
     constexpr tensor<T, Head, Tail...> as_tensor() const {
@@ -494,20 +727,48 @@ struct view<T, Head> {
     }
 
     constexpr T& operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return pointer[index];
     }
 
     constexpr T const& operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return pointer[index];
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return pointer[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return pointer[detail::offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return pointer[detail::checked_offset(shape(), indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return pointer[detail::checked_offset(shape(), indices...)];
+    }
 
-    // TODO =
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr view& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(pointer, Head, value);
+        simd::fill(pointer, Head, value);
     }
 
     constexpr tensor<T, Head> as_tensor() const {
@@ -561,20 +822,48 @@ struct view<T, -1> {
     }
 
     constexpr T& operator[](dim_t index) {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return pointer[index];
     }
 
     constexpr T const& operator[](dim_t index) const {
+        GAME_TENSOR_CHECK(index >= 0 && (size_t)index < size());
         return pointer[index];
     }
 
-    // TODO at
-    // TODO operator()
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& operator()(I... indices) {
+        return pointer[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& operator()(I... indices) const {
+        return pointer[detail::offset(shape_, indices...)];
+    }
+
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T& at(I... indices) {
+        return pointer[detail::checked_offset(shape_, indices...)];
+    }
 
-    // TODO =
+    template <typename... I>
+        requires (sizeof...(I) == ndim)
+    constexpr T const& at(I... indices) const {
+        return pointer[detail::checked_offset(shape_, indices...)];
+    }
+
+    template <typename E>
+        requires is_expression_v<E>
+    constexpr view& operator=(E const& e) {
+        assign(*this, e);
+        return *this;
+    }
 
     constexpr void fill(T const& value) {
-        std::fill_n(pointer, shape_.head(), value);
+        simd::fill(pointer, shape_.head(), value);
     }
 
     constexpr tensor<T, -1> as_tensor() const {
@@ -593,24 +882,18 @@ struct view<T, -1> {
 };
 
 
-// TODO arithmetic operators?
-
-
 #define GAME_TENSOR_MAKE_OPERATORS(ltype, rtype)                                           \
                                                                                            \
 template <typename T, dim_t... L, dim_t... R>                                              \
 constexpr bool operator==(ltype<T, L...> const& left, rtype<T, R...> const& right) {       \
     if (left.shape() != right.shape())                                                     \
         return false;                                                                      \
-    return std::equal(left.data(), left.data() + left.shape().product(), right.data());    \
+    return simd::equal(left.data(), right.data(), left.shape().product());                 \
 }                                                                                          \
                                                                                            \
 template <typename T, dim_t... L, dim_t... R>                                              \
 constexpr auto operator<=>(ltype<T, L...> const& left, rtype<T, R...> const& right) {      \
-    return std::lexicographical_compare_three_way(                                         \
-        left.data(), left.data() + left.size(),                                            \
-        right.data(), right.data() + right.size()                                          \
-    );                                                                                     \
+    return simd::compare_three_way(left.data(), left.size(), right.data(), right.size());  \
 }                                                                                          \
 
 GAME_TENSOR_MAKE_OPERATORS(tensor, tensor)
@@ -636,6 +919,56 @@ struct hash<view<T, Head, Tail...>> {
 };
 
 
+/*
+ * Copy a batch of equally-shaped tensors (or views) into consecutive slots of
+ * a larger one, e.g. to build a N*H*W minibatch of grids. Items are obtained
+ * by applying the projection to each element of the random-access range, and
+ * are written directly into their slot. Large batches may be split over
+ * several threads.
+ */
+template <typename Range, typename Projection>
+concept stackable = requires(Range const& items, Projection projection) {
+    std::invoke(projection, *std::begin(items)).shape();
+    std::invoke(projection, *std::begin(items)).data();
+};
+
+template <typename T, dim_t... D, typename Range, typename Projection = std::identity>
+    requires (sizeof...(D) > 0 && stackable<Range, Projection>)
+void stack(Range const& items, view<T, -1, D...> destination, Projection projection = {}, unsigned num_threads = 1) {
+    size_t count = std::size(items);
+    if (destination.shape().head() != (dim_t)count)
+        throw shape_error();
+    auto first = std::begin(items);
+    auto slot_shape = destination.shape().tail().to_array();
+    for (size_t i = 0; i < count; ++i)
+        if (std::invoke(projection, first[i]).shape().to_array() != slot_shape)
+            throw shape_error();
+    size_t slot_size = destination.shape().tail().product();
+    T* target = destination.data();
+    parallel_for(count, num_threads, [&](size_t i) {
+        auto const& item = std::invoke(projection, first[i]);
+        std::copy_n(item.data(), slot_size, target + i * slot_size);
+    });
+}
+
+template <typename T, dim_t... D, typename Range, typename Projection = std::identity>
+    requires (sizeof...(D) > 0 && stackable<Range, Projection>)
+tensor<T, -1, D...> stack(Range const& items, Projection projection = {}, unsigned num_threads = 1) {
+    size_t count = std::size(items);
+    std::array<dim_t, 1 + sizeof...(D)> dims = { (dim_t)count, (D < 0 ? 0 : D)... };
+    if (count > 0) {
+        auto slot_shape = std::invoke(projection, *std::begin(items)).shape().to_array();
+        std::copy(slot_shape.begin(), slot_shape.end(), dims.begin() + 1);
+    }
+    shape_t<-1, D...> shape = {};
+    if (!shape.from_array(dims))
+        throw shape_error();
+    tensor<T, -1, D...> result(shape);
+    stack(items, result.as_view(), projection, num_threads);
+    return result;
+}
+
+
 template <typename T, dim_t Head, dim_t... Tail>
 void to_json(nlohmann::json& j, view<T, Head, Tail...> const value) {
     j = nlohmann::json::array();
@@ -0,0 +1,204 @@
+#ifndef GAME_TRANSPOSITION_TABLE_HPP
+#define GAME_TRANSPOSITION_TABLE_HPP
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "./hash.hpp"
+
+
+namespace game {
+
+
+/*
+ * A fixed-size hash table, shared by concurrent searches, where each position
+ * is identified by its (deterministic) game::hash.
+ *
+ * Entries are grouped in cache-line buckets, and the number of buckets is a
+ * power of two. There is no lock: each entry is made of relaxed atomic words,
+ * and its check word stores the key XOR-ed with all payload words, following
+ * the lockless scheme by Hyatt and Mann:
+ *   https://craftychess.com/hyatt/hashing.html
+ * A read that overlaps a concurrent write sees inconsistent words, fails the
+ * check, and is reported as a miss. Hence, a probe never returns a torn
+ * payload, but may miss an entry that is being written.
+ *
+ * As usual for transposition tables, this is lossy: entries may be evicted by
+ * other positions, according to the replacement policy.
+ */
+
+
+enum class replacement {
+
+    // Keep the deepest entries, the shallowest one of a full bucket is replaced
+    depth_preferred,
+
+    // Always replace, either the matching, an empty, or an arbitrary entry
+    always
+};
+
+
+template <typename Payload, replacement Policy = replacement::depth_preferred>
+struct transposition_table {
+
+    static_assert(std::is_trivially_copyable_v<Payload> && std::is_default_constructible_v<Payload>);
+    static_assert(Policy != replacement::depth_preferred || requires(Payload const& p) { int(p.depth); },
+        "depth-preferred replacement requires a depth member in the payload");
+
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t num_words = (sizeof(Payload) + 7) / 8;
+
+private:
+
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::array<std::atomic<uint64_t>, num_words> words;
+    };
+
+public:
+
+    static constexpr size_t entries_per_bucket = std::max<size_t>(1, cache_line_size / sizeof(Entry));
+
+private:
+
+    struct alignas(cache_line_size) Bucket {
+        Entry entries[entries_per_bucket];
+    };
+
+public:
+
+    // Capacity is rounded up, to a power-of-two number of buckets
+    explicit transposition_table(size_t min_entries = size_t(1) << 20) :
+        num_buckets(std::bit_ceil(std::max<size_t>(1, (min_entries + entries_per_bucket - 1) / entries_per_bucket))),
+        buckets(new Bucket[num_buckets]())
+    {}
+
+    size_t capacity() const noexcept {
+        return num_buckets * entries_per_bucket;
+    }
+
+    size_t get_memory_usage() const noexcept {
+        return num_buckets * sizeof(Bucket);
+    }
+
+    // Not thread-safe with respect to concurrent accesses
+    void clear() noexcept {
+        for (size_t i = 0; i < num_buckets; ++i)
+            for (Entry& entry : buckets[i].entries) {
+                entry.check.store(0, std::memory_order_relaxed);
+                for (auto& word : entry.words)
+                    word.store(0, std::memory_order_relaxed);
+            }
+    }
+
+    std::optional<Payload> find_hash(uint64_t hash) const noexcept {
+        uint64_t key = to_key(hash);
+        Bucket const& bucket = buckets[key & (num_buckets - 1)];
+        for (Entry const& entry : bucket.entries) {
+            std::array<uint64_t, num_words> words;
+            if (load(entry, words) == key) {
+                Payload payload;
+                std::memcpy(&payload, words.data(), sizeof(Payload));
+                return payload;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void insert_hash(uint64_t hash, Payload const& payload) noexcept {
+        uint64_t key = to_key(hash);
+        Bucket& bucket = buckets[key & (num_buckets - 1)];
+
+        // Select the entry to replace
+        Entry* victim = nullptr;
+        int victim_depth = 0;
+        for (Entry& entry : bucket.entries) {
+            std::array<uint64_t, num_words> words;
+            uint64_t entry_key = load(entry, words);
+            if (entry_key == key) {
+                if constexpr (Policy == replacement::depth_preferred)
+                    if (get_depth(words) > payload.depth)
+                        return;
+                victim = &entry;
+                break;
+            }
+            if (entry_key == 0) {
+                if (!victim || victim_depth >= 0) {
+                    victim = &entry;
+                    victim_depth = -1;
+                }
+                continue;
+            }
+            if constexpr (Policy == replacement::depth_preferred) {
+                int depth = get_depth(words);
+                if (!victim || (victim_depth >= 0 && depth < victim_depth)) {
+                    victim = &entry;
+                    victim_depth = depth;
+                }
+            }
+        }
+        if (!victim)
+            victim = &bucket.entries[(key >> 32) % entries_per_bucket];
+
+        // Write payload first, then the check word, so that concurrent readers detect partial writes
+        std::array<uint64_t, num_words> words = {};
+        std::memcpy(words.data(), &payload, sizeof(Payload));
+        uint64_t check = key;
+        for (size_t i = 0; i < num_words; ++i) {
+            victim->words[i].store(words[i], std::memory_order_relaxed);
+            check ^= words[i];
+        }
+        victim->check.store(check, std::memory_order_release);
+    }
+
+    template <typename K>
+    std::optional<Payload> find(K const& key) const {
+        return find_hash(hash_value(key));
+    }
+
+    template <typename K>
+    void insert(K const& key, Payload const& payload) {
+        insert_hash(hash_value(key), payload);
+    }
+
+private:
+
+    size_t num_buckets;
+    std::unique_ptr<Bucket[]> buckets;
+
+    // Zero denotes an empty entry
+    static uint64_t to_key(uint64_t hash) noexcept {
+        return hash ? hash : 1;
+    }
+
+    // Recover the key of an entry, which is garbage if the entry is being written
+    static uint64_t load(Entry const& entry, std::array<uint64_t, num_words>& words) noexcept {
+        uint64_t key = entry.check.load(std::memory_order_acquire);
+        for (size_t i = 0; i < num_words; ++i) {
+            words[i] = entry.words[i].load(std::memory_order_relaxed);
+            key ^= words[i];
+        }
+        return key;
+    }
+
+    static int get_depth(std::array<uint64_t, num_words> const& words) noexcept {
+        Payload payload;
+        std::memcpy(&payload, words.data(), sizeof(Payload));
+        return int(payload.depth);
+    }
+};
+
+
+}
+
+
+#endif
@@ -1,7 +1,12 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <random>
+#include <thread>
+#include <vector>
+
 #include "game/bounce.hpp"
+#include "game/bounce_batch.hpp"
 
 
 using namespace game;
@@ -33,6 +38,11 @@ TEST_CASE("Sanity checks on small board") {
     state = state->get_action_at({ 1, 1 }, { 0, 2 })->sample_next_state();
     CHECK(!state->has_ended());
     CHECK(state->get_player() == 1);
+    CHECK(!state->moves.empty());
+    CHECK(state->get_moves().size() == state->board.get_moves(1).size());
+    for (MoveId id : state->get_moves())
+        CHECK(state->board.get_moves(1).contains(id.to_move(3)));
+    CHECK(state->get_actions_at({ 0, 4 }).size() == state->board.get_moves_at(1, { 0, 4 }).size());
 
     // Turn 2
     state = state->get_action_at({ 2, 4 }, { 0, 3 })->sample_next_state();
@@ -52,6 +62,263 @@ TEST_CASE("Sanity checks on small board") {
 }
 
 
+TEST_CASE("Row occupancy") {
+
+    tensor<int8_t, -1, -1> grid(6, 3);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0,
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0
+    };
+
+    Board board(grid);
+    CHECK(board.row_counts == std::vector<int16_t> { 0, 3, 0, 0, 3, 0 });
+    CHECK(board.row_counts.is_inline());
+    CHECK(board.get_row(0) == 1);
+    CHECK(board.get_row(1) == 4);
+
+    board.apply({ { 0, 1 }, { 0, 2 } });
+    board.apply({ { 1, 1 }, { 1, 3 } });
+    board.apply({ { 2, 1 }, { 2, 2 } });
+    CHECK(board.get_row_count(1) == 0);
+    CHECK(board.get_row_count(2) == 2);
+    CHECK(board.get_row_count(3) == 1);
+    CHECK(board.get_row(0) == 2);
+    CHECK(board.get_row(1) == 4);
+
+    board.apply({ { 0, 4 }, { 0, 5 } });
+    board.apply({ { 1, 4 }, { 1, 5 } });
+    board.apply({ { 2, 4 }, { 2, 5 } });
+    CHECK(board.is_row_empty(4));
+    CHECK(board.get_row(1) == 5);
+
+    Board expected(board.grid);
+    CHECK(expected.row_counts == board.row_counts);
+    CHECK(expected.get_bottom_row() == board.get_bottom_row());
+    CHECK(expected.get_top_row() == board.get_top_row());
+}
+
+
+TEST_CASE("Bitboard walk matches recursive walk") {
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> value_distribution(0, 3);
+    std::bernoulli_distribution occupied_distribution(0.4);
+
+    std::array<std::array<int, 2>, 4> sizes = { { { 9, 6 }, { 6, 3 }, { 8, 8 }, { 3, 7 } } };
+    for (auto [height, width] : sizes) {
+        for (int i = 0; i < 50; ++i) {
+            Grid grid(height, width);
+            for (size_t j = 0; j < grid.size(); ++j)
+                grid.data()[j] = occupied_distribution(generator) ? value_distribution(generator) : 0;
+
+            for (int y = 0; y < height; ++y)
+                for (int x = 0; x < width; ++x)
+                    for (int dy : { -1, 1 }) {
+                        Walk walk(grid);
+                        walk.collect(x, y, dy);
+                        BitWalk bit_walk(grid);
+                        bit_walk.collect(x, y, dy);
+                        CHECK(walk.moves == bit_walk.moves);
+                    }
+        }
+    }
+
+    // Negative cells (e.g. from JSON) block moves, but cannot be bounced on
+    std::uniform_int_distribution<int> signed_distribution(-1, 3);
+    for (int i = 0; i < 50; ++i) {
+        Grid grid(9, 6);
+        for (size_t j = 0; j < grid.size(); ++j)
+            grid.data()[j] = occupied_distribution(generator) ? signed_distribution(generator) : 0;
+        Board board(grid);
+        for (int player : { 0, 1 })
+            CHECK(board.collect_moves<Walk>(player) == board.collect_moves<BitWalk>(player));
+        for (int y = 0; y < 9; ++y)
+            for (int x = 0; x < 6; ++x)
+                for (int dy : { -1, 1 }) {
+                    Walk walk(grid);
+                    walk.collect(x, y, dy);
+                    BitWalk bit_walk(grid);
+                    bit_walk.collect(x, y, dy);
+                    CHECK(walk.moves == bit_walk.moves);
+                }
+    }
+
+    // Also compare along random playthroughs
+    tensor<int8_t, -1, -1> initial_grid(9, 6);
+    initial_grid.storage = std::vector<int8_t>{
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0
+    };
+    for (int i = 0; i < 20; ++i) {
+        Board board(initial_grid);
+        for (int player = 0;; player = 1 - player) {
+            auto moves = board.collect_moves<Walk>(player);
+            CHECK(moves == board.collect_moves<BitWalk>(player));
+            if (moves.empty())
+                break;
+            auto it = moves.begin();
+            std::advance(it, std::uniform_int_distribution<size_t>(0, moves.size() - 1)(generator));
+            board.apply(*it);
+            int y = it->target[1];
+            if (y == 0 || y == board.get_height() - 1)
+                break;
+        }
+    }
+}
+
+
+TEST_CASE("Move identifiers") {
+
+    Move move = { { 2, 1 }, { 1, 3 } };
+    MoveId id = MoveId::from_move(move, 3);
+    CHECK(id.source == 5);
+    CHECK(id.target == 10);
+    CHECK(id.to_move(3) == move);
+    CHECK(id.to_index(18) == 5 * 18 + 10);
+    CHECK(MoveId::from_index(id.to_index(18), 18) == id);
+}
+
+
+TEST_CASE("Dense actions") {
+
+    tensor<int8_t, -1, -1> grid(6, 3);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0,
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0
+    };
+
+    auto config = std::make_shared<Config>(grid);
+    auto state = config->sample_initial_state();
+
+    CHECK(num_actions(*config) == 18 * 18);
+
+    auto action = state->get_action_at({ 2, 1 }, { 1, 3 });
+    int index = action_index(*action);
+    CHECK(index == 5 * 18 + 10);
+    CHECK(*action_from_index(*state, index) == *action);
+    CHECK_THROWS(action_from_index(*state, 0));
+    CHECK_THROWS(action_from_index(*state, 18 * 18));
+
+    tensor<uint8_t, -1> mask(18 * 18);
+    legal_mask(*state, mask.as_view());
+    CHECK(std::count(mask.data(), mask.data() + mask.size(), 1) == 8);
+    for (auto const& a : state->get_actions())
+        CHECK(mask[action_index(*a)] == 1);
+
+    auto next_state = action->sample_next_state();
+    std::array<State const*, 2> states = { state.get(), next_state.get() };
+    tensor<uint8_t, -1, -1> masks(2, 18 * 18);
+    legal_mask(states, masks.as_view());
+    CHECK(masks[0] == mask);
+    CHECK(size_t(std::count(masks[1].data(), masks[1].data() + 18 * 18, 1)) == next_state->get_actions().size());
+
+    auto grids = stack(states);
+    CHECK(grids.shape().to_array() == std::array<dim_t, 3> { 2, 6, 3 });
+    CHECK(grids[0] == state->get_grid());
+    CHECK(grids[1] == next_state->get_grid());
+}
+
+
+TEST_CASE("Move handles") {
+
+    // Random playouts, where both representations must agree
+    std::mt19937 generator(0);
+    for (int game = 0; game < 20; ++game) {
+        auto config = std::make_shared<Config>(sample_grid(9, 6, generator));
+        auto state = config->sample_initial_state();
+        State copy = *state;
+        for (int ply = 0; ply < 100 && !state->has_ended(); ++ply) {
+            auto const& ids = copy.get_moves();
+            auto actions = state->get_actions();
+            REQUIRE(ids.size() == actions.size());
+            for (size_t i = 0; i < ids.size(); ++i)
+                CHECK(actions[i]->get_move_id() == ids[i]);
+            size_t i = generator() % ids.size();
+            CHECK(copy.is_legal(ids[i]));
+            copy.apply(MoveId(ids[i]));
+            state = actions[i]->sample_next_state();
+            CHECK(copy == *state);
+            CHECK(copy.winner == state->winner);
+        }
+    }
+
+    // Illegal moves are rejected
+    tensor<int8_t, -1, -1> grid(6, 3);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0,
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0
+    };
+    auto config = std::make_shared<Config>(grid);
+    auto state = config->sample_initial_state();
+    MoveId id = MoveId::from_move({ { 2, 1 }, { 1, 3 } }, 3);
+    CHECK(state->is_legal(id));
+    CHECK(!state->is_legal({ 3, 4 }));
+    CHECK_THROWS(state->apply(MoveId{ 3, 4 }));
+    state->apply(id);
+    CHECK(state->get_player() == 1);
+    CHECK(state->get_grid()[3][1] == 3);
+    CHECK(!state->is_legal(id));
+
+    // Moves remain valid after the state is modified
+    auto moves = state->get_moves();
+    size_t count = moves.size();
+    state->apply(moves[0]);
+    CHECK(moves.size() == count);
+}
+
+
+TEST_CASE("Concurrent reads") {
+
+    // Const methods of a fresh state only read, hence they can be called from several threads
+    std::mt19937 generator(0);
+    auto config = std::make_shared<Config>(sample_grid(9, 6, generator));
+    auto state = State::from_json(config->sample_initial_state()->to_json(), config);
+    State const& shared = *state;
+    int cells = shared.board.grid.size();
+
+    std::vector<tensor<uint8_t, -1>> masks(8, tensor<uint8_t, -1>(cells * cells));
+    std::vector<size_t> counts(masks.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < masks.size(); ++t)
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 100; ++i) {
+                legal_mask(shared, masks[t].as_view());
+                counts[t] = 0;
+                for (MoveId id : shared.get_moves())
+                    counts[t] += shared.is_legal(id);
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    tensor<uint8_t, -1> mask(cells * cells);
+    legal_mask(*config->sample_initial_state(), mask.as_view());
+    for (size_t t = 0; t < masks.size(); ++t) {
+        CHECK(masks[t] == mask);
+        CHECK(counts[t] == shared.get_moves().size());
+    }
+}
+
+
 TEST_CASE("Hash and equal") {
     tensor<int8_t, -1, -1> grid(9, 6);
     grid.storage = std::vector<int8_t>{
@@ -93,6 +360,14 @@ TEST_CASE("Hash and equal") {
 
     CHECK(hash_value(state_a) != hash_value(initial_state));
     CHECK(hash_value(state_a->get_action_at({ 5, 1 }, { 5, 2 })) != hash_value(initial_state->get_action_at({ 5, 1 }, { 5, 2 })));
+
+    // Cached hashes are reset by apply
+    CHECK(state_a->cached_hash.has_value());
+    State state_c = *state_a;
+    state_c.apply(*state_a->get_action_at({ 5, 1 }, { 5, 2 }));
+    CHECK(!state_c.cached_hash.has_value());
+    CHECK(hash_value(state_c) == hash_value(state_c.get_identity_tuple()));
+    CHECK(hash_value(state_c) != hash_value(*state_a));
 }
 
 
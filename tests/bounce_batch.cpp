@@ -0,0 +1,114 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "game/bounce_batch.hpp"
+
+
+using namespace game;
+using namespace game::bounce;
+
+
+TEST_CASE("Random initial grids") {
+
+    std::mt19937 generator(0);
+
+    for (int i = 0; i < 100; ++i) {
+        Grid grid = sample_grid(9, 6, generator);
+        CHECK_NOTHROW(Config{ grid });
+        for (int x = 0; x < 6; ++x) {
+            CHECK(grid[0][x] == 0);
+            CHECK(grid[8][x] == 0);
+            CHECK(grid[1][x] > 0);
+            CHECK(grid[1][x] == grid[7][5 - x]);
+        }
+    }
+}
+
+
+TEST_CASE("Batch matches state") {
+
+    int size = 8;
+    BatchEnv env(size, 9, 6, 123);
+
+    // Replay each game with the regular state implementation
+    std::vector<std::shared_ptr<State>> states;
+    for (int i = 0; i < size; ++i) {
+        Grid grid = env.grids[i].as_tensor();
+        states.push_back(std::make_shared<Config>(grid)->sample_initial_state());
+    }
+
+    std::mt19937 generator(7);
+    tensor<uint8_t, -1, -1> masks(size, env.get_num_actions());
+    tensor<int, -1> actions(size);
+    for (int turn = 0; turn < 200; ++turn) {
+        env.legal_mask(masks.as_view());
+        for (int i = 0; i < size; ++i) {
+            tensor<uint8_t, -1> mask(env.get_num_actions());
+            legal_mask(*states[i], mask.as_view());
+            CHECK(masks[i] == mask);
+
+            actions[i] = -1;
+            auto state_actions = states[i]->get_actions();
+            if (!state_actions.empty()) {
+                auto action = state_actions[std::uniform_int_distribution<size_t>(0, state_actions.size() - 1)(generator)];
+                actions[i] = action_index(*action);
+                states[i] = action->sample_next_state();
+            }
+        }
+
+        auto step = env.step(std::as_const(actions).as_view());
+        for (int i = 0; i < size; ++i) {
+            Grid grid = states[i]->get_grid();
+            CHECK(std::equal(grid.data(), grid.data() + grid.size(), step.observations[i].data()));
+            CHECK(step.players[i] == states[i]->get_player());
+            CHECK((bool)step.dones[i] == states[i]->has_ended());
+            if (step.dones[i] && actions[i] >= 0)
+                CHECK(env.rewards[i] == states[i]->get_reward());
+        }
+    }
+
+    env.reset(0);
+    CHECK_THROWS(env.step(0, 0));
+}
+
+
+TEST_CASE("Invalid batches") {
+
+    CHECK_THROWS_AS(BatchEnv(1, 9, 8), std::runtime_error);
+
+    int size = 4;
+    BatchEnv env(size, 9, 6, 5);
+    tensor<uint8_t, -1> mask(env.get_num_actions());
+    tensor<int, -1> actions(size);
+    for (int i = 0; i < size; ++i) {
+        env.legal_mask(i, mask.as_view());
+        actions[i] = int(std::find(mask.data(), mask.data() + mask.size(), 1) - mask.data());
+    }
+
+    // An invalid action in the middle leaves all games unchanged
+    actions[2] = 0;
+    tensor<int8_t, -1, -1, -1> grids = env.grids;
+    tensor<int8_t, -1> players = env.players;
+    CHECK_THROWS(env.step(std::as_const(actions).as_view()));
+    CHECK(env.grids == grids);
+    CHECK(env.players == players);
+}
+
+
+TEST_CASE("Reset in place") {
+
+    BatchEnv env(4, 9, 6, 0);
+    int8_t const* data = env.grids.data();
+
+    env.dones[2] = 1;
+    env.players[2] = -1;
+    env.reset_done();
+    CHECK(env.dones[2] == 0);
+    CHECK(env.players[2] == 0);
+    CHECK(env.grids.data() == data);
+}
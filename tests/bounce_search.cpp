@@ -0,0 +1,172 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <bit>
+#include <random>
+#include <vector>
+
+#include "game/bounce_batch.hpp"
+#include "game/bounce_search.hpp"
+
+
+using namespace game;
+using namespace game::bounce;
+
+
+TEST_CASE("Immediate win") {
+
+    tensor<int8_t, -1, -1> grid(6, 3);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0,
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0
+    };
+
+    auto config = std::make_shared<Config>(grid);
+    auto state = config->sample_initial_state()
+        ->get_action_at({ 1, 1 }, { 0, 2 })->sample_next_state()
+        ->get_action_at({ 2, 4 }, { 0, 3 })->sample_next_state()
+        ->get_action_at({ 2, 1 }, { 2, 2 })->sample_next_state();
+
+    // Player 1 can bounce to the goal row, as in the sanity checks
+    Searcher searcher(10);
+    auto result = searcher.search(*state, 4);
+    CHECK(result.depth == 1);
+    CHECK(result.score == Searcher::win_score - 1);
+    REQUIRE(result.principal_variation.size() == 1);
+    auto next_state = state->get_action_at(result.principal_variation[0].source, result.principal_variation[0].target)->sample_next_state();
+    CHECK(next_state->has_ended());
+    CHECK(next_state->get_reward() == tensor<float, 2> { -1.0f, 1.0f });
+}
+
+
+TEST_CASE("Principal variation is legal") {
+
+    tensor<int8_t, -1, -1> grid(8, 6);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0
+    };
+
+    auto config = std::make_shared<Config>(grid);
+    auto state = config->sample_initial_state();
+
+    Searcher searcher(16);
+    auto result = searcher.search(*state, 4);
+    CHECK(result.depth == 4);
+    CHECK(result.nodes > 0);
+    CHECK(result.get_nodes_per_second() >= 0.0);
+    CHECK(!result.principal_variation.empty());
+
+    for (Move const& move : result.principal_variation) {
+        REQUIRE(!state->has_ended());
+        CHECK_NOTHROW(state = state->get_action_at(move.source, move.target)->sample_next_state());
+    }
+
+    // Evaluation is antisymmetric
+    BitWalk position(config->board.grid);
+    CHECK(Searcher::evaluate(position, 0) == -Searcher::evaluate(position, 1));
+    CHECK(Searcher::evaluate(*config->sample_initial_state()) == 0);
+}
+
+
+TEST_CASE("Time limit") {
+
+    tensor<int8_t, -1, -1> grid(9, 6);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0,
+        1, 2, 3, 3, 2, 1,
+        0, 0, 0, 0, 0, 0
+    };
+
+    auto config = std::make_shared<Config>(grid);
+    Searcher searcher(16);
+    auto result = searcher.search(*config->sample_initial_state(), 100, 0.05);
+    CHECK(result.depth >= 1);
+    CHECK(result.depth < 100);
+    CHECK(result.seconds < 1.0);
+}
+
+
+// Plain negamax, without pruning nor table, with the same rules and evaluation as Searcher
+int minimax(BitWalk& position, int player, int depth, int ply) {
+    auto generate = [&](int p) {
+        std::vector<MoveId> result;
+        int y = position.get_row(p);
+        if (y >= 0)
+            for (int x = 0; x < position.width; ++x) {
+                int source = y * position.width + x;
+                for (Bitboard targets = position.get_targets(source, p ? -1 : 1); targets; targets &= targets - 1)
+                    result.push_back({ uint8_t(source), uint8_t(std::countr_zero(targets)) });
+            }
+        return result;
+    };
+    int other = player ? 0 : 1;
+    auto candidates = generate(player);
+    if (candidates.empty())
+        return generate(other).empty() ? 0 : -Searcher::win_score + ply;
+    if (depth <= 0)
+        return Searcher::evaluate(position, player);
+    int best_score = -Searcher::win_score - 1;
+    for (MoveId id : candidates) {
+        int score;
+        int target_row = id.target / position.width;
+        if (target_row == 0 || target_row == position.height - 1)
+            score = Searcher::win_score - ply - 1;
+        else {
+            position.apply(id.source, id.target);
+            score = -minimax(position, other, depth - 1, ply + 1);
+            position.apply(id.target, id.source);
+        }
+        best_score = std::max(best_score, score);
+    }
+    return best_score;
+}
+
+
+TEST_CASE("Search matches minimax") {
+
+    // A small table, so that entries are often overwritten
+    std::mt19937 generator(3);
+    Searcher searcher(10);
+    for (int height : { 5, 6, 7 }) {
+        for (int game = 0; game < 10; ++game) {
+            auto config = std::make_shared<Config>(sample_grid(height, 3, generator));
+            auto state = config->sample_initial_state();
+            for (int ply = 0; ply < 6 && !state->has_ended(); ++ply) {
+
+                // The table is kept across searches, to also exercise stale entries
+                auto result = searcher.search(*state, 5);
+                BitWalk position(state->board.grid);
+                CHECK(result.score == minimax(position, state->player, result.depth, 0));
+
+                // The principal variation is legal
+                auto current = state;
+                CHECK(!result.principal_variation.empty());
+                for (Move const& move : result.principal_variation) {
+                    REQUIRE(!current->has_ended());
+                    CHECK_NOTHROW(current = current->get_action_at(move.source, move.target)->sample_next_state());
+                }
+
+                auto actions = state->get_actions();
+                state = actions[generator() % actions.size()]->sample_next_state();
+            }
+        }
+    }
+}
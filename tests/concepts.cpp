@@ -0,0 +1,89 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <random>
+#include <vector>
+
+#include "game/bounce_batch.hpp"
+#include "game/concepts.hpp"
+#include "game/connect.hpp"
+
+
+using namespace game;
+
+
+static_assert(Game<connect::Config>);
+static_assert(Game<bounce::Config>);
+
+static_assert(GameState<connect::State>);
+static_assert(GameAction<bounce::Action>);
+static_assert(!GameState<connect::Config>);
+static_assert(!GameConfig<connect::State>);
+static_assert(!GameAction<tensor<int, 2>>);
+
+static_assert(game_traits<connect::State>::num_players == 2);
+static_assert(game_traits<connect::State>::has_dense_actions);
+static_assert(game_traits<connect::State>::has_moves);
+static_assert(game_traits<connect::State>::has_legal_mask);
+static_assert(game_traits<connect::State>::has_stack);
+static_assert(game_traits<connect::State>::has_hash_cache);
+static_assert(!game_traits<connect::State>::has_undo);
+static_assert(!game_traits<connect::State>::has_bitboard);
+
+static_assert(game_traits<bounce::State>::has_dense_actions);
+static_assert(game_traits<bounce::State>::has_moves);
+static_assert(game_traits<bounce::State>::has_legal_mask);
+static_assert(game_traits<bounce::State>::has_bitboard);
+static_assert(!game_traits<bounce::State>::has_undo);
+
+
+// Generic random playout, which samples from the legal mask when available
+template <typename Config, typename Generator>
+    requires Game<Config>
+std::shared_ptr<typename Config::State> play_randomly(Config& config, Generator& generator, bool use_mask) {
+    using State = typename Config::State;
+    using traits = game_traits<State>;
+
+    auto state = config.sample_initial_state();
+    std::vector<uint8_t> buffer;
+    std::vector<int> indices;
+    while (!state->has_ended()) {
+        if constexpr (traits::has_dense_actions && traits::has_legal_mask) {
+            if (use_mask) {
+                buffer.resize(num_actions(config));
+                legal_mask(*state, view<uint8_t, -1>(buffer.data(), { int(buffer.size()) }));
+                indices.clear();
+                for (size_t i = 0; i < buffer.size(); ++i)
+                    if (buffer[i])
+                        indices.push_back(i);
+                int index = indices[generator() % indices.size()];
+                state = action_from_index(*state, index)->sample_next_state();
+                continue;
+            }
+        }
+        auto actions = state->get_actions();
+        state = actions[generator() % actions.size()]->sample_next_state();
+    }
+    return state;
+}
+
+
+TEST_CASE("Generic playout") {
+
+    auto connect_config = std::make_shared<connect::Config>(6, 7, 4);
+    std::mt19937 generator(0);
+    for (bool use_mask : { false, true }) {
+        auto state = play_randomly(*connect_config, generator, use_mask);
+        CHECK(state->has_ended());
+        auto reward = state->get_reward();
+        CHECK(reward[0] + reward[1] == 0.0f);
+    }
+
+    auto bounce_config = std::make_shared<bounce::Config>(bounce::sample_grid(9, 6, generator));
+    auto state = play_randomly(*bounce_config, generator, true);
+    CHECK(state->has_ended());
+
+    // The bitboard fast path agrees with the grid
+    bounce::State::Position position(bounce_config->board.grid);
+    CHECK(std::popcount(position.occupied) == 12);
+}
@@ -1,6 +1,8 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
 
+#include <random>
+
 #include "game/connect.hpp"
 
 
@@ -46,6 +48,73 @@ TEST_CASE("Sanity checks on small board") {
 }
 
 
+TEST_CASE("Dense actions") {
+
+    auto config = std::make_shared<Config>(2, 3, 2);
+    auto state = config->sample_initial_state();
+    state = state->get_action_at(1)->sample_next_state();
+    state = state->get_action_at(1)->sample_next_state();
+
+    CHECK(num_actions(*config) == 3);
+    CHECK(action_index(*state->get_action_at(2)) == 2);
+    CHECK(*action_from_index(*state, 2) == *state->get_action_at(2));
+    CHECK_THROWS(action_from_index(*state, 1));
+
+    tensor<uint8_t, -1> mask(3);
+    legal_mask(*state, mask.as_view());
+    CHECK(mask == tensor<uint8_t, 3> { 1, 0, 1 });
+
+    auto initial_state = config->sample_initial_state();
+    std::array<State const*, 2> states = { state.get(), initial_state.get() };
+    tensor<uint8_t, -1, -1> masks(2, 3);
+    legal_mask(states, masks.as_view());
+    CHECK(masks == tensor<uint8_t, 2, 3> { 1, 0, 1, 1, 1, 1 });
+
+    tensor<int8_t, -1, -1, -1> grids(2, 2, 3);
+    stack(states, grids.as_view());
+    CHECK(grids[0] == state->get_grid());
+    CHECK(grids[1] == initial_state->get_grid());
+    CHECK(stack(states) == grids);
+}
+
+
+TEST_CASE("Move handles") {
+
+    // Random playouts, where both representations must agree
+    auto config = std::make_shared<Config>(6, 7, 4);
+    std::mt19937 generator(0);
+    for (int game = 0; game < 20; ++game) {
+        auto state = config->sample_initial_state();
+        State copy = *state;
+        while (!state->has_ended()) {
+            auto moves = copy.get_moves();
+            auto actions = state->get_actions();
+            REQUIRE(moves.size() == actions.size());
+            for (size_t i = 0; i < moves.size(); ++i)
+                CHECK(actions[i]->get_move() == moves[i]);
+            size_t i = generator() % moves.size();
+            copy.apply(moves[i]);
+            state = actions[i]->sample_next_state();
+            CHECK(copy == *state);
+            CHECK(copy.winner == state->winner);
+        }
+        CHECK(copy.get_moves().empty());
+        CHECK(!copy.is_legal({ 0 }));
+        CHECK_THROWS(copy.apply(Move{ 0 }));
+    }
+
+    // Invalid columns
+    auto state = config->sample_initial_state();
+    CHECK(!state->is_legal({ 7 }));
+    CHECK_THROWS(state->apply(Move{ 7 }));
+    for (int i = 0; i < 6; ++i)
+        state->apply(Move{ 2 });
+    CHECK(!state->is_legal({ 2 }));
+    CHECK_THROWS(state->apply(Move{ 2 }));
+    CHECK(state->get_moves().size() == 6);
+}
+
+
 TEST_CASE("Hash and equal") {
     auto config = std::make_shared<Config>(6, 7, 4);
 
@@ -79,6 +148,92 @@ TEST_CASE("Hash and equal") {
 }
 
 
+TEST_CASE("Hash cache") {
+    auto config = std::make_shared<Config>(6, 7, 4);
+    auto state = config->sample_initial_state()->get_action_at(3)->sample_next_state();
+
+    // Filled lazily, and equal to the uncached hash
+    CHECK(!state->cached_hash.has_value());
+    size_t h = hash_value(*state);
+    CHECK(state->cached_hash.has_value());
+    CHECK(h == hash_value(state->get_identity_tuple()));
+    CHECK(hash_value(*state) == h);
+
+    // Copies keep the slot, which is reset when applying an action
+    State copy = *state;
+    CHECK(copy.cached_hash.has_value());
+    copy.apply(*state->get_action_at(2));
+    CHECK(!copy.cached_hash.has_value());
+    CHECK(hash_value(copy) == hash_value(copy.get_identity_tuple()));
+    CHECK(hash_value(copy) != h);
+
+    auto action = state->get_action_at(1);
+    size_t a = hash_value(*action);
+    CHECK(action->cached_hash.has_value());
+    CHECK(a == hash_value(action->get_identity_tuple()));
+}
+
+
+TEST_CASE("Fast equality") {
+    auto config = std::make_shared<Config>(6, 7, 4);
+    auto initial_state = config->sample_initial_state();
+    std::vector<std::shared_ptr<State>> states = {
+        initial_state,
+        initial_state->get_action_at(3)->sample_next_state(),
+        initial_state->get_action_at(4)->sample_next_state(),
+        initial_state->get_action_at(3)->sample_next_state()->get_action_at(4)->sample_next_state(),
+        initial_state->get_action_at(4)->sample_next_state()->get_action_at(3)->sample_next_state(),
+    };
+
+    // Same grid, other player
+    auto other = std::make_shared<State>(*states[3]);
+    other->player = 1 - other->player;
+    other->cached_hash.reset();
+    states.push_back(other);
+
+    // Shortcuts agree with identity tuples, whether hashes are memoized or not
+    for (int pass = 0; pass < 2; ++pass) {
+        for (auto const& a : states)
+            for (auto const& b : states) {
+                bool expected = a->get_identity_tuple() == b->get_identity_tuple();
+                CHECK((*a == *b) == expected);
+                CHECK(a->is_equal(*b) == expected);
+                CHECK((a->board == b->board) == (a->board.grid == b->board.grid));
+                CHECK((a->board <=> b->board) == (a->board.grid <=> b->board.grid));
+            }
+        for (auto const& state : states)
+            hash_value(*state);
+    }
+
+    auto action = states[3]->get_action_at(0);
+    CHECK(*action == *std::make_shared<State>(*states[3])->get_action_at(0));
+    CHECK(*action != *states[4]->get_action_at(1));
+    CHECK(*action != *states[1]->get_action_at(0));
+}
+
+
+TEST_CASE("Trajectory fingerprint") {
+    auto config = std::make_shared<Config>(6, 7, 4);
+
+    auto play = [&](std::vector<int> const& columns) {
+        hasher h;
+        auto state = config->sample_initial_state();
+        h.update(state);
+        for (int column : columns) {
+            auto action = state->get_action_at(column);
+            state = action->sample_next_state();
+            h.update(action->column).update(state);
+        }
+        return h.digest128();
+    };
+
+    // Transpositions reach the same state, through different trajectories
+    CHECK(play({ 3, 2, 4 }) == play({ 3, 2, 4 }));
+    CHECK(play({ 3, 2, 4 }) != play({ 4, 2, 3 }));
+    CHECK(play({ 3, 2 }) != play({ 3, 2, 4 }));
+}
+
+
 TEST_CASE("JSON") {
 
     auto config = std::make_shared<Config>(2, 3, 2);
@@ -0,0 +1,124 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "game/dlpack.hpp"
+#include "game/tensor.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Data types") {
+
+    DLDataType i8 = dlpack_dtype<int8_t>();
+    CHECK(i8.code == kDLInt);
+    CHECK(i8.bits == 8);
+    CHECK(i8.lanes == 1);
+
+    DLDataType i32 = dlpack_dtype<int const>();
+    CHECK(i32.code == kDLInt);
+    CHECK(i32.bits == 32);
+
+    DLDataType f32 = dlpack_dtype<float>();
+    CHECK(f32.code == kDLFloat);
+    CHECK(f32.bits == 32);
+
+    DLDataType u8 = dlpack_dtype<uint8_t>();
+    CHECK(u8.code == kDLUInt);
+}
+
+
+TEST_CASE("Export tensor") {
+
+    // Large enough to live on the heap, which must be handed over as is
+    tensor<float, -1, 3> x(100);
+    for (dim_t i = 0; i < 100; ++i)
+        x[i][1] = float(i);
+    float const* data = x.data();
+
+    DLManagedTensor* managed = to_dlpack(std::move(x));
+    DLTensor const& t = managed->dl_tensor;
+    CHECK(t.data == data);
+    CHECK(t.device.device_type == kDLCPU);
+    CHECK(t.ndim == 2);
+    CHECK(t.dtype.code == kDLFloat);
+    CHECK(t.shape[0] == 100);
+    CHECK(t.shape[1] == 3);
+    CHECK(t.strides[0] == 3);
+    CHECK(t.strides[1] == 1);
+    CHECK(t.byte_offset == 0);
+    CHECK(static_cast<float*>(t.data)[3 * 42 + 1] == 42.0f);
+    managed->deleter(managed);
+
+    // Small tensors are moved along with their inline storage
+    tensor<int8_t, 2, 2> y = { 1, 2, 3, 4 };
+    managed = to_dlpack(std::move(y));
+    CHECK(managed->dl_tensor.shape[0] == 2);
+    CHECK(static_cast<int8_t*>(managed->dl_tensor.data)[3] == 4);
+    managed->deleter(managed);
+}
+
+
+TEST_CASE("Export view") {
+
+    tensor<int, -1, -1> x(4, 5);
+    x.fill(7);
+
+    DLManagedTensor* managed = to_dlpack(x.as_view());
+    CHECK(managed->dl_tensor.data == x.data());
+    CHECK(managed->dl_tensor.dtype.bits == 32);
+    CHECK(managed->dl_tensor.shape[0] == 4);
+    CHECK(managed->dl_tensor.shape[1] == 5);
+
+    // Round-trip, without copy
+    auto v = from_dlpack<int, -1, -1>(managed);
+    CHECK(v.data() == x.data());
+    CHECK(v == x);
+    v[1][2] = 3;
+    CHECK(x[1][2] == 3);
+    managed->deleter(managed);
+    CHECK(x[1][2] == 3);
+}
+
+
+TEST_CASE("Import") {
+
+    int8_t buffer[2 + 2 * 3] = { 0, 0, 1, 2, 3, 4, 5, 6 };
+    int64_t shape[2] = { 2, 3 };
+    int64_t strides[2] = { 3, 1 };
+
+    DLTensor t = {};
+    t.data = buffer;
+    t.device = { kDLCPU, 0 };
+    t.ndim = 2;
+    t.dtype = dlpack_dtype<int8_t>();
+    t.shape = shape;
+    t.strides = nullptr;
+    t.byte_offset = 2;
+
+    auto v = from_dlpack<int8_t, -1, 3>(t);
+    CHECK(v.shape() == shape_t<-1, 3>(2));
+    CHECK(v[1][2] == 6);
+
+    auto w = from_dlpack<int8_t const, 2, 3>(t);
+    CHECK(w[0][0] == 1);
+
+    t.strides = strides;
+    CHECK(from_dlpack<int8_t, -1, -1>(t).data() == buffer + 2);
+
+    // Invalid descriptors are rejected
+    CHECK_THROWS_AS((from_dlpack<int8_t, -1, 2>(t)), shape_error);
+    CHECK_THROWS_AS((from_dlpack<int8_t, -1>(t)), shape_error);
+    CHECK_THROWS_AS((from_dlpack<int, -1, -1>(t)), std::invalid_argument);
+
+    strides[0] = 1;
+    strides[1] = 2;
+    CHECK_THROWS_AS((from_dlpack<int8_t, -1, -1>(t)), std::invalid_argument);
+
+    t.strides = nullptr;
+    t.device.device_type = kDLCUDA;
+    CHECK_THROWS_AS((from_dlpack<int8_t, -1, -1>(t)), std::invalid_argument);
+}
@@ -0,0 +1,92 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "game/expression.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Arithmetic") {
+
+    tensor<float, 2> a = { 1.0f, -1.0f };
+    tensor<float, 2> b = { 0.5f, 2.0f };
+
+    tensor<float, 2> c;
+    c = a + b * 2.0f;
+    CHECK(c == tensor<float, 2> { 2.0f, 3.0f });
+
+    c = -a - 1.0f;
+    CHECK(c == tensor<float, 2> { -2.0f, 0.0f });
+
+    auto d = eval(a * b);
+    CHECK(d == tensor<float, 2> { 0.5f, -2.0f });
+
+    // In-place update is fine, as it is elementwise
+    c = c + c;
+    CHECK(c == tensor<float, 2> { -4.0f, 0.0f });
+
+    static_assert(decltype(a + b)::is_static);
+}
+
+
+TEST_CASE("Dynamic shapes") {
+
+    tensor<int, -1, -1> x(2, 3);
+    x.storage = std::vector<int> { 1, 2, 3, 4, 5, 6 };
+    tensor<int, 2, 3> y = { 6, 5, 4, 3, 2, 1 };
+
+    tensor<int, -1, -1> z;
+    z = x + y;
+    CHECK(z.shape() == shape_t<2, 3>());
+    CHECK(z.storage == std::vector<int> { 7, 7, 7, 7, 7, 7 });
+
+    static_assert(decltype(x + y)::is_static);
+    static_assert(!decltype(x + x)::is_static);
+
+    // Views can be assigned too
+    x[1] = y[0] * 10;
+    CHECK(x.storage == std::vector<int> { 1, 2, 3, 60, 50, 40 });
+
+    tensor<int, -1, -1> w(3, 2);
+    CHECK_THROWS_AS(x + w, shape_error);
+    CHECK_THROWS_AS(y = w + w, shape_error);
+}
+
+
+TEST_CASE("Comparisons and where") {
+
+    tensor<int8_t, 2, 3> grid = { -1, 0, 1, 1, -1, 0 };
+
+    tensor<uint8_t, 2, 3> mask;
+    mask = equal(grid, 1);
+    CHECK(mask == tensor<uint8_t, 2, 3> { 0, 0, 1, 1, 0, 0 });
+
+    tensor<float, 2, 3> value;
+    value = where(greater_equal(grid, 0), grid * 2.0f, 0.5f);
+    CHECK(value == tensor<float, 2, 3> { 0.5f, 0.0f, 2.0f, 2.0f, 0.5f, 0.0f });
+
+    value = maximum(grid, 0) + minimum(grid, 0);
+    CHECK(value == tensor<float, 2, 3> { -1.0f, 0.0f, 1.0f, 1.0f, -1.0f, 0.0f });
+}
+
+
+TEST_CASE("Reductions") {
+
+    tensor<int8_t, 2, 3> grid = { -1, 0, 1, 1, -1, 0 };
+
+    CHECK(sum(equal(grid, -1)) == 2);
+    CHECK(sum(grid) == 0);
+    CHECK(sum(grid[1]) == 0);
+    CHECK(max(grid) == 1);
+    CHECK(min(grid * 3) == -3);
+    CHECK(any(less(grid, 0)));
+    CHECK(!all(less(grid, 0)));
+    CHECK(all(less_equal(grid, 1)));
+
+    tensor<float, 2> reward = { 1.0f, -1.0f };
+    CHECK(sum(reward * reward) == 2.0f);
+
+    tensor<int, -1> empty;
+    CHECK_THROWS_AS(max(empty), shape_error);
+}
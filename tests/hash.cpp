@@ -3,6 +3,9 @@
 
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <memory>
+#include <set>
 #include <vector>
 
 #include "game/hash.hpp"
@@ -46,3 +49,104 @@ TEST_CASE("Collections") {
     CHECK(hash_many(y));
     CHECK(hash_many(z));
 }
+
+
+TEST_CASE("Contiguous ranges") {
+
+    tensor<int8_t, 2, 3> x = { 1, 2, 3, -1, 0, 3 };
+    tensor<int8_t, -1, -1> y(2, 3);
+    std::copy_n(x.data(), 6, y.data());
+    std::vector<int8_t> z(x.data(), x.data() + 6);
+    std::array<int8_t, 6> w;
+    std::copy_n(x.data(), 6, w.data());
+
+    // All representations of the same values agree
+    CHECK(hash_value(x) == hash_value(y));
+    CHECK(hash_value(x) == hash_value(x.as_view()));
+    CHECK(hash_value(x) == hash_value(y.as_view()));
+    CHECK(hash_value(x) == hash_value(z));
+    CHECK(hash_value(x) == hash_value(w));
+    CHECK(hash_value(x) == hash_bytes(x.data(), 6));
+
+    // Hashes are deterministic, across processes
+    if constexpr (sizeof(size_t) == 8) {
+        CHECK(hash_value(x) == 0x45587a77704a8ebc);
+        CHECK(hash_bytes("abc", 3) == 0xa328457f52f71b65);
+    }
+
+    // Any single-bit change, at any length, must change the hash
+    std::set<size_t> hashes;
+    size_t count = 0;
+    for (size_t size = 0; size <= 100; ++size) {
+        std::vector<uint8_t> data(size, 0x55);
+        hashes.insert(hash_value(data));
+        ++count;
+        for (size_t i = 0; i < size; ++i) {
+            for (int bit = 0; bit < 8; ++bit) {
+                data[i] ^= 1 << bit;
+                hashes.insert(hash_value(data));
+                data[i] ^= 1 << bit;
+                ++count;
+            }
+        }
+    }
+    CHECK(hashes.size() == count);
+
+    // Non-integral types are still hashed by value
+    std::vector<float> a = { 0.0f, 1.0f };
+    std::vector<float> b = { -0.0f, 1.0f };
+    CHECK(hash_value(a) == hash_value(b));
+}
+
+
+TEST_CASE("Streaming") {
+
+    tensor<int8_t, 2, 3> x = { 1, 2, 3, -1, 0, 3 };
+    std::vector<int8_t> y(x.data(), x.data() + 6);
+
+    // Same values, same digest
+    hasher a;
+    a.update(x).update(int8_t(1)).update(2.0f);
+    hasher b;
+    b.update(y).update(int8_t(1)).update(2.0f);
+    CHECK(a.digest() == b.digest());
+    CHECK(a.digest128() == b.digest128());
+    CHECK(a.digest128().low != a.digest128().high);
+
+    // Digests do not modify the state
+    CHECK(a.digest() == a.digest());
+    a.update(3);
+    CHECK(a.digest() != b.digest());
+    b.update(3);
+    CHECK(a.digest128() == b.digest128());
+
+    // Tuples are fed element-wise
+    hasher c;
+    c.update(std::make_tuple(int8_t(1), 2.0f));
+    hasher d;
+    d.update(int8_t(1)).update(2.0f);
+    CHECK(c.digest128() == d.digest128());
+
+    // Pointers, raw or smart, are fed by their pointee
+    int8_t z = 1;
+    auto w = std::make_shared<int8_t>(1);
+    CHECK(hasher().update(&z).digest128() == hasher().update(int8_t(1)).digest128());
+    CHECK(hasher().update(w).digest128() == hasher().update(&z).digest128());
+
+    // Order, record boundaries and empty records matter
+    std::set<hash128> digests;
+    digests.insert(hasher().digest128());
+    digests.insert(hasher().update_bytes("", 0).digest128());
+    digests.insert(hasher().update_bytes("abc", 3).digest128());
+    digests.insert(hasher().update_bytes("ab", 2).update_bytes("c", 1).digest128());
+    digests.insert(hasher().update_bytes("c", 1).update_bytes("ab", 2).digest128());
+    digests.insert(hasher(1).update_bytes("abc", 3).digest128());
+    CHECK(digests.size() == 6);
+
+    // Digests are deterministic, across processes
+    if constexpr (sizeof(size_t) == 8) {
+        hash128 digest = hasher().update(x).update(int8_t(1)).digest128();
+        CHECK(digest.low == 0x9183cfc7a574c665);
+        CHECK(digest.high == 0x6d054dd66e2d07f2);
+    }
+}
@@ -0,0 +1,138 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "game/bounce.hpp"
+#include "game/connect.hpp"
+#include "game/json_stream.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Tensor") {
+
+    tensor<int, -1, -1> x;
+    parse_json("[[1, 2, 3], [4, 5, 6]]", x);
+    CHECK(x.shape().to_array() == std::array<dim_t, 2> { 2, 3 });
+    CHECK(x == tensor<int, 2, 3> { 1, 2, 3, 4, 5, 6 });
+
+    // Same result as the DOM-based parser
+    tensor<float, -1, 2> y;
+    std::istringstream stream("[[0.5, 1], [2, -3.25], [4, 5]]");
+    parse_json(stream, y);
+    CHECK(y == nlohmann::json::parse("[[0.5, 1], [2, -3.25], [4, 5]]").get<tensor<float, -1, 2>>());
+
+    tensor<int8_t, 2, 2> z;
+    parse_json("[[1, -1], [0, 3]]", z);
+    CHECK(z == tensor<int8_t, 2, 2> { 1, -1, 0, 3 });
+
+    // Empty arrays keep static dimensions
+    parse_json("[]", y);
+    CHECK(y.shape().to_array() == std::array<dim_t, 2> { 0, 2 });
+    parse_json("[]", x);
+    CHECK(x.shape().to_array() == std::array<dim_t, 2> { 0, 0 });
+    parse_json("[[], []]", x);
+    CHECK(x.shape().to_array() == std::array<dim_t, 2> { 2, 0 });
+
+    // Large tensors go to the heap
+    std::string text = "[";
+    for (int i = 0; i < 1000; ++i)
+        text += (i ? ", [" : "[") + std::to_string(i) + ", " + std::to_string(-i) + "]";
+    text += "]";
+    tensor<int, -1, -1> w;
+    parse_json(text, w);
+    CHECK(w.shape().to_array() == std::array<dim_t, 2> { 1000, 2 });
+    CHECK(w(999, 1) == -999);
+
+    // Invalid shapes
+    CHECK_THROWS_AS(parse_json("[[1, 2], [3]]", x), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2], 3]", x), shape_error);
+    CHECK_THROWS_AS(parse_json("[1, 2]", x), shape_error);
+    CHECK_THROWS_AS(parse_json("[[[1]]]", x), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2, 3]]", y), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2], [3, 4], [5, 6]]", z), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, \"a\"]]", x), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2]] [[3]]", x), nlohmann::json::parse_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2]", x), nlohmann::json::parse_error);
+}
+
+
+TEST_CASE("View") {
+
+    tensor<int, -1, -1, -1> batch(2, 2, 2);
+    batch.fill(0);
+    parse_json("[[1, 2], [3, 4]]", batch[1]);
+    CHECK(batch[0] == tensor<int, 2, 2> { 0, 0, 0, 0 });
+    CHECK(batch[1] == tensor<int, 2, 2> { 1, 2, 3, 4 });
+
+    CHECK_THROWS_AS(parse_json("[[1, 2, 3], [4, 5, 6]]", batch[0]), shape_error);
+    CHECK_THROWS_AS(parse_json("[[1, 2]]", batch[0]), shape_error);
+}
+
+
+TEST_CASE("Connect states") {
+
+    auto config = std::make_shared<connect::Config>(4, 5, 3);
+    auto state = config->sample_initial_state()
+        ->get_action_at(1)->sample_next_state()
+        ->get_action_at(2)->sample_next_state()
+        ->get_action_at(1)->sample_next_state();
+
+    auto parsed = parse_state_json<connect::State>(state->to_json().dump(), config);
+    CHECK(*parsed == *state);
+
+    // Unknown keys are ignored
+    parsed = parse_state_json<connect::State>(R"({"meta": {"a": [1, {}]}, "player": 1, "grid": [[-1]], "x": null})", config);
+    CHECK(parsed->player == 1);
+    CHECK(parsed->board.grid(0, 0) == -1);
+
+    CHECK_THROWS(parse_state_json<connect::State>(R"({"grid": [[1]]})", config));
+    CHECK_THROWS(parse_state_json<connect::State>(R"({"grid": 1, "player": 0})", config));
+    CHECK_THROWS(parse_state_json<connect::State>(R"({"grid": [[1]], "player": 1000})", config));
+    CHECK_THROWS(parse_state_json<connect::State>(R"([1, 2])", config));
+}
+
+
+TEST_CASE("Bounce states") {
+
+    bounce::Grid grid(6, 3);
+    grid.storage = std::vector<int8_t>{
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0,
+        0, 0, 0,
+        1, 2, 3,
+        0, 0, 0
+    };
+    auto config = std::make_shared<bounce::Config>(grid);
+
+    std::vector<std::shared_ptr<bounce::State>> states = { config->sample_initial_state() };
+    while (!states.back()->has_ended() && states.size() < 20)
+        states.push_back(states.back()->get_actions().front()->sample_next_state());
+
+    std::stringstream stream;
+    for (auto const& state : states)
+        stream << state->to_json().dump() << "\n\n";
+
+    std::vector<std::shared_ptr<bounce::State>> parsed;
+    size_t count = for_each_state_ndjson<bounce::State>(stream, config, [&](auto state) {
+        parsed.push_back(state);
+    });
+
+    CHECK(count == states.size());
+    REQUIRE(parsed.size() == states.size());
+    for (size_t i = 0; i < states.size(); ++i) {
+        CHECK(*parsed[i] == *states[i]);
+
+        // Derived data must be consistent
+        CHECK(parsed[i]->board.get_bottom_row() == states[i]->board.get_bottom_row());
+        CHECK(parsed[i]->board.get_top_row() == states[i]->board.get_top_row());
+        if (!states[i]->has_ended())
+            CHECK(parsed[i]->get_actions().size() == states[i]->get_actions().size());
+    }
+}
@@ -0,0 +1,130 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "game/connect.hpp"
+#include "game/json_stream.hpp"
+#include "game/memory.hpp"
+#include "game/state_pool.hpp"
+#include "game/tensor.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Arena") {
+
+    game::arena arena(256);
+
+    void* a = arena.allocate(10, 1);
+    void* b = arena.allocate(100, 64);
+    CHECK(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+    CHECK(a != b);
+
+    // Larger than a chunk
+    void* c = arena.allocate(1000, 8);
+    CHECK(c);
+    size_t capacity = arena.get_capacity();
+    CHECK(capacity >= 1256);
+
+    // Memory is reused after reset
+    arena.reset();
+    CHECK(arena.allocate(10, 1) == a);
+    CHECK(arena.allocate(500, 8) != nullptr);
+    CHECK(arena.get_capacity() == capacity);
+
+    arena.release();
+    CHECK(arena.get_capacity() == 0);
+}
+
+
+TEST_CASE("Memory scope") {
+
+    game::arena arena;
+    std::pmr::unsynchronized_pool_resource pool(&arena);
+
+    CHECK(get_memory_resource() == std::pmr::get_default_resource());
+
+    tensor<float, -1, -1> x;
+    {
+        memory_scope scope(&pool);
+        CHECK(get_memory_resource() == &pool);
+
+        tensor<float, -1, -1> y(100, 100);
+        CHECK(!y.storage.is_inline());
+        CHECK(arena.get_capacity() >= 100 * 100 * sizeof(float));
+
+        x = y;
+        y.fill(1.0f);
+    }
+    CHECK(get_memory_resource() == std::pmr::get_default_resource());
+
+    // Storage is still returned to the pool, even outside of the scope
+    x.reshape({ 1000, 1000 });
+    x.fill(2.0f);
+    CHECK(x[999][999] == 2.0f);
+}
+
+
+struct counting_resource : std::pmr::memory_resource {
+    size_t count = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++count;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+
+TEST_CASE("Game nodes") {
+
+    auto config = std::make_shared<connect::Config>(6, 7, 4);
+
+    // States and actions are allocated from the current resource, with their inline grids
+    counting_resource resource;
+    std::shared_ptr<connect::State> state;
+    {
+        memory_scope scope(&resource);
+        state = config->sample_initial_state();
+        CHECK(state->board.grid.storage.is_inline());
+        CHECK(resource.count == 1);
+        state = state->get_action_at(3)->sample_next_state();
+        CHECK(resource.count == 3);
+    }
+    auto other = config->sample_initial_state()->get_action_at(3)->sample_next_state();
+    CHECK(resource.count == 3);
+    CHECK(*other == *state);
+
+    // Same for parsed and interned states
+    state_pool<connect::State> pool;
+    {
+        memory_scope scope(&resource);
+        auto parsed = parse_state_json<connect::State>(state->to_json().dump(), config);
+        CHECK(resource.count == 4);
+        auto handle = pool.acquire(*parsed);
+        CHECK(resource.count == 5);
+        CHECK(*handle == *state);
+    }
+
+    // Whole trees can be dropped into an arena
+    game::arena arena;
+    {
+        memory_scope scope(&arena);
+        for (int i = 0; i < 10; ++i)
+            state = state->get_action_at(i % 7)->sample_next_state();
+        CHECK(arena.get_capacity() > 0);
+    }
+    state.reset();
+    arena.reset();
+}
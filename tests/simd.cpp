@@ -0,0 +1,128 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "game/simd.hpp"
+#include "game/tensor.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Mismatch") {
+
+    std::mt19937 generator(42);
+
+    // Cover all tail lengths and positions, around vector widths
+    for (size_t size = 0; size < 100; ++size) {
+        std::vector<unsigned char> a(size);
+        for (auto& x : a)
+            x = (unsigned char)generator();
+
+        CHECK(simd::mismatch_scalar(a.data(), a.data(), size) == size);
+        CHECK(simd::mismatch(a.data(), a.data(), size) == size);
+
+        for (size_t i = 0; i < size; ++i) {
+            std::vector<unsigned char> b = a;
+            b[i] ^= 0x80;
+            if (i + 1 < size)
+                b[size - 1] ^= 1;
+            CHECK(simd::mismatch_scalar(a.data(), b.data(), size) == i);
+#ifdef GAME_SIMD_SSE2
+            CHECK(simd::mismatch_sse2(a.data(), b.data(), size) == i);
+#endif
+#ifdef GAME_SIMD_AVX2_TARGET
+            if (simd::has_avx2())
+                CHECK(simd::mismatch_avx2(a.data(), b.data(), size) == i);
+#endif
+            CHECK(simd::mismatch(a.data(), b.data(), size) == i);
+        }
+    }
+}
+
+
+TEST_CASE("Comparison") {
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(-3, 3);
+
+    for (int k = 0; k < 1000; ++k) {
+        std::vector<int8_t> a(generator() % 70);
+        std::vector<int8_t> b(generator() % 70);
+        for (auto& x : a)
+            x = distribution(generator);
+        for (auto& x : b)
+            x = distribution(generator);
+        if (k % 2) {
+            b = a;
+            if (!b.empty() && k % 3)
+                b[generator() % b.size()] = distribution(generator);
+        }
+
+        bool expected_equal = a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+        auto expected_order = std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(), b.end());
+        if (a.size() == b.size())
+            CHECK(simd::equal(a.data(), b.data(), a.size()) == expected_equal);
+        CHECK(simd::compare_three_way(a.data(), a.size(), b.data(), b.size()) == expected_order);
+    }
+
+    // Sign must be respected, unlike memcmp
+    int8_t x[] = { 1, -1 };
+    int8_t y[] = { 1, 1 };
+    CHECK(simd::compare_three_way(x, 2, y, 2) == std::strong_ordering::less);
+
+    int u[] = { 0, 256 };
+    int v[] = { 0, 1 };
+    CHECK(simd::compare_three_way(u, 2, v, 2) == std::strong_ordering::greater);
+
+    // Floating-point numbers are compared by value
+    float f[] = { 0.0f };
+    float g[] = { -0.0f };
+    CHECK(simd::equal(f, g, 1));
+}
+
+
+TEST_CASE("Fill") {
+
+    std::vector<int> a(37, 5);
+
+    simd::fill(a.data(), a.size(), 0);
+    CHECK(std::all_of(a.begin(), a.end(), [](int x) { return x == 0; }));
+
+    simd::fill(a.data(), a.size(), -1);
+    CHECK(std::all_of(a.begin(), a.end(), [](int x) { return x == -1; }));
+
+    simd::fill(a.data(), a.size(), 258);
+    CHECK(std::all_of(a.begin(), a.end(), [](int x) { return x == 258; }));
+
+    simd::fill(a.data(), 0, 7);
+    CHECK(a[0] == 258);
+}
+
+
+TEST_CASE("Tensor") {
+
+    tensor<int8_t, -1, -1> a(20, 20);
+    tensor<int8_t, 20, 20> b;
+    a.fill(-1);
+    b.fill(-1);
+    CHECK(a == b);
+    CHECK((a <=> b) == std::strong_ordering::equal);
+
+    b[19][19] = 1;
+    CHECK(a != b);
+    CHECK(a < b);
+
+    a[0][0] = 2;
+    CHECK(a > b);
+    CHECK(b.as_view() < a.as_view());
+
+    tensor<int8_t, -1, -1> c(19, 21);
+    c.fill(-1);
+    CHECK(c != b);
+}
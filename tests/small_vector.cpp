@@ -0,0 +1,88 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "game/small_vector.hpp"
+#include "game/tensor.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Inline and heap storage") {
+
+    small_vector<int, 4> a = { 1, 2, 3 };
+    CHECK(a.is_inline());
+    CHECK(a.size() == 3);
+    CHECK(a == std::vector<int> { 1, 2, 3 });
+
+    a.resize(10);
+    CHECK(!a.is_inline());
+    CHECK(a.size() == 10);
+    CHECK(a[2] == 3);
+    CHECK(a[9] == 0);
+
+    a.resize(2);
+    CHECK(a == std::vector<int> { 1, 2 });
+}
+
+
+TEST_CASE("Copy and move") {
+
+    small_vector<int, 4> a = { 1, 2, 3 };
+    small_vector<int, 4> b = { 1, 2, 3, 4, 5, 6 };
+
+    small_vector<int, 4> c = a;
+    CHECK(c == a);
+    CHECK(c.is_inline());
+
+    small_vector<int, 4> d = b;
+    CHECK(d == b);
+    CHECK(d.data() != b.data());
+
+    int const* pointer = d.data();
+    small_vector<int, 4> e = std::move(d);
+    CHECK(e.data() == pointer);
+    CHECK(d.empty());
+
+    e = a;
+    CHECK(e == a);
+    a = std::move(b);
+    CHECK(a == std::vector<int> { 1, 2, 3, 4, 5, 6 });
+    CHECK(b.empty());
+}
+
+
+TEST_CASE("Non-trivial elements") {
+
+    small_vector<std::string, 2> a = { "foo", "bar" };
+    a.push_back("a string which is long enough to be allocated on the heap");
+    CHECK(a.size() == 3);
+    CHECK(!a.is_inline());
+
+    small_vector<std::string, 2> b = a;
+    CHECK(b == a);
+    b.resize(1);
+    CHECK(b == std::vector<std::string> { "foo" });
+
+    a = b;
+    CHECK(a == b);
+}
+
+
+TEST_CASE("Small tensors are inline") {
+
+    tensor<int8_t, -1, -1> grid(9, 6);
+    CHECK(grid.storage.is_inline());
+
+    tensor<int8_t, -1, -1> copy = grid;
+    CHECK(copy.storage.is_inline());
+    CHECK(copy == grid);
+
+    tensor<int8_t, -1, -1> large(100, 100);
+    CHECK(!large.storage.is_inline());
+    CHECK(hash_value(large) == hash_value(large.as_view()));
+}
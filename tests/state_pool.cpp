@@ -0,0 +1,131 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "game/connect.hpp"
+#include "game/state_pool.hpp"
+
+
+using namespace game;
+using namespace game::connect;
+
+
+TEST_CASE("Interning") {
+    auto config = std::make_shared<Config>(6, 7, 4);
+    auto initial_state = config->sample_initial_state();
+
+    auto state_a = initial_state
+        ->get_action_at(1)->sample_next_state()
+        ->get_action_at(2)->sample_next_state()
+        ->get_action_at(3)->sample_next_state();
+    auto state_b = initial_state
+        ->get_action_at(3)->sample_next_state()
+        ->get_action_at(2)->sample_next_state()
+        ->get_action_at(1)->sample_next_state();
+    REQUIRE(*state_a == *state_b);
+
+    state_pool<State> pool;
+    auto a = pool.intern(state_a);
+    auto b = pool.intern(state_b);
+    auto c = pool.intern(*initial_state);
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(pool.size() == 2);
+    CHECK(pool.use_count(a) == 2);
+
+    // The first shared pointer is kept, others are copied
+    CHECK(pool.get(a) == state_a);
+    CHECK(pool.get(c) != initial_state);
+    CHECK(pool[c] == *initial_state);
+
+    // Evicted when the last reference is released, and the id is reused
+    pool.release(a);
+    CHECK(pool.size() == 2);
+    pool.release(b);
+    CHECK(pool.size() == 1);
+    CHECK(pool.intern(*initial_state) == c);
+    CHECK(pool.use_count(c) == 2);
+    auto d = pool.intern(state_a->get_action_at(0)->sample_next_state());
+    CHECK(d == a);
+    CHECK(pool.size() == 2);
+}
+
+
+TEST_CASE("Handles") {
+    auto config = std::make_shared<Config>(6, 7, 4);
+    auto initial_state = config->sample_initial_state();
+
+    state_pool<State> pool;
+    {
+        auto a = pool.acquire(initial_state);
+        auto b = pool.acquire(*initial_state);
+        auto c = pool.acquire(initial_state->get_action_at(0)->sample_next_state());
+        CHECK(a == b);
+        CHECK(a != c);
+        CHECK(a->get_player() == 0);
+        CHECK(*c != *a);
+        CHECK(pool.use_count(a.id()) == 2);
+
+        auto d = c;
+        CHECK(pool.use_count(c.id()) == 2);
+        d = a;
+        CHECK(pool.use_count(c.id()) == 1);
+        CHECK(pool.use_count(a.id()) == 3);
+        auto e = std::move(d);
+        CHECK(!d);
+        CHECK(pool.use_count(a.id()) == 3);
+        CHECK(pool.size() == 2);
+    }
+    CHECK(pool.size() == 0);
+}
+
+
+TEST_CASE("Concurrent interning") {
+    auto config = std::make_shared<Config>(4, 4, 3);
+
+    // Same random playouts on all threads, so that most states are shared
+    state_pool<State> pool(4);
+    std::vector<std::vector<state_pool<State>::id_type>> ids(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 generator(0);
+            for (int game = 0; game < 200; ++game) {
+                auto state = config->sample_initial_state();
+                while (!state->has_ended()) {
+                    ids[t].push_back(pool.intern(state));
+                    auto actions = state->get_actions();
+                    state = actions[generator() % actions.size()]->sample_next_state();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int t = 1; t < 4; ++t)
+        CHECK(ids[t] == ids[0]);
+
+    // Each distinct state is stored once, and ids are dense
+    std::vector<unsigned> counts(pool.size());
+    for (auto id : ids[0]) {
+        REQUIRE(id < counts.size());
+        ++counts[id];
+    }
+    for (size_t id = 0; id < counts.size(); ++id)
+        CHECK(pool.use_count(id) == 4 * counts[id]);
+
+    // Release everything concurrently
+    threads.clear();
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&, t] {
+            for (auto id : ids[t])
+                pool.release(id);
+        });
+    for (auto& thread : threads)
+        thread.join();
+    CHECK(pool.size() == 0);
+}
@@ -0,0 +1,80 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <array>
+
+#include "game/strided_view.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Dense view") {
+
+    tensor<int, 2, 3> x = {
+        1, 2, 3,
+        4, 5, 6
+    };
+
+    auto s = as_strided(x);
+    CHECK(s.shape() == std::array<dim_t, 2> { 2, 3 });
+    CHECK(s.strides() == std::array<ptrdiff_t, 2> { 3, 1 });
+    CHECK(s.is_contiguous());
+    CHECK(s(1, 2) == 6);
+    CHECK(s[1][0] == 4);
+
+    s(0, 0) = 7;
+    CHECK(x[0][0] == 7);
+}
+
+
+TEST_CASE("Transpose, flip and slice") {
+
+    tensor<int, -1, -1> x(2, 3);
+    x.storage = std::vector<int> {
+        1, 2, 3,
+        4, 5, 6
+    };
+
+    auto t = as_strided(x).transpose();
+    CHECK(!t.is_contiguous());
+    CHECK(t.as_tensor() == tensor<int, 3, 2> { 1, 4, 2, 5, 3, 6 });
+
+    auto f = as_strided(x).flip(0);
+    CHECK(f.as_tensor() == tensor<int, 2, 3> { 4, 5, 6, 1, 2, 3 });
+
+    auto g = as_strided(x).flip(0).flip(1);
+    CHECK(g.as_tensor() == tensor<int, 2, 3> { 6, 5, 4, 3, 2, 1 });
+
+    auto s = as_strided(x).slice(1, 1, 3);
+    CHECK(s.shape() == std::array<dim_t, 2> { 2, 2 });
+    CHECK(s.as_tensor() == tensor<int, 2, 2> { 2, 3, 5, 6 });
+
+    auto r = as_strided(x).slice(0, 1, 2);
+    CHECK(r.is_contiguous());
+    CHECK(r.as_tensor() == tensor<int, 1, 3> { 4, 5, 6 });
+
+    CHECK_THROWS_AS(as_strided(x).slice(1, 2, 4), shape_error);
+    CHECK_THROWS_AS(as_strided(x).flip(2), shape_error);
+}
+
+
+TEST_CASE("Copy") {
+
+    tensor<int8_t, -1, -1> x(3, 2);
+    x.storage = std::vector<int8_t> {
+        1, 2,
+        3, 4,
+        5, 6
+    };
+
+    tensor<int8_t, -1, -1> y(2, 3);
+    as_strided(std::as_const(x)).transpose(0, 1).copy_to(y);
+    CHECK(y.storage == std::vector<int8_t> { 1, 3, 5, 2, 4, 6 });
+
+    tensor<int8_t, 3, 2> z;
+    as_strided(x).copy_to(z);
+    CHECK(z == x);
+
+    CHECK_THROWS_AS(as_strided(x).copy_to(y), shape_error);
+}
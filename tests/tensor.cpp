@@ -3,6 +3,10 @@
 
 #include <algorithm>
 #include <array>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "game/tensor.hpp"
 
@@ -90,6 +94,94 @@ TEST_CASE("Reshape") {
 }
 
 
+TEST_CASE("Element access") {
+
+    tensor<int, 2, 3, 4> x;
+    tensor<int, -1, 3, -1> y(2, 4);
+    for (int i = 0; i < 24; ++i) {
+        x.data()[i] = i;
+        y.data()[i] = i;
+    }
+
+    CHECK(x(1, 2, 3) == x[1][2][3]);
+    CHECK(y(1, 2, 3) == y[1][2][3]);
+    CHECK(x(0, 1, 2) == 6);
+    CHECK(y(1, 0, 1) == 13);
+    CHECK(x.as_view()(1, 1, 1) == 17);
+    CHECK(y.as_view()(1, 1, 1) == 17);
+
+    y(0, 0, 0) = 42;
+    CHECK(y[0][0][0] == 42);
+    y.at(0, 0, 0) = 0;
+    CHECK(y.at(0, 0, 0) == 0);
+
+    tensor<int, -1> z(3);
+    z(2) = 5;
+    CHECK(z.at(2) == 5);
+
+    view<int, 3, -1> v = y[1];
+    CHECK(v(2, 3) == 23);
+    CHECK(v.at(2, 3) == 23);
+
+    // Bounds are checked by at, in all dimensions
+    CHECK_THROWS_AS(x.at(2, 0, 0), std::out_of_range);
+    CHECK_THROWS_AS(x.at(0, 3, 0), std::out_of_range);
+    CHECK_THROWS_AS(y.at(0, 0, 4), std::out_of_range);
+    CHECK_THROWS_AS(y.at(0, -1, 0), std::out_of_range);
+    CHECK_THROWS_AS(z.at(3), std::out_of_range);
+    CHECK_THROWS_AS(v.at(3, 0), std::out_of_range);
+    CHECK_THROWS_AS(std::as_const(y).as_view().at(2, 0, 0), std::out_of_range);
+
+    shape_t<-1, 3, -1> shape = { 2, 4 };
+    CHECK(flat_index(shape, { 1, 2, 3 }) == 23);
+    CHECK(in_bounds(shape_t<2, 3>(), { 1, 2 }));
+    CHECK(!in_bounds(shape_t<2, 3>(), { 2, 0 }));
+}
+
+
+TEST_CASE("Stack") {
+
+    std::vector<tensor<int, -1, -1>> items;
+    for (int i = 0; i < 5; ++i) {
+        items.emplace_back(2, 3);
+        items.back().fill(i);
+    }
+
+    tensor<int, -1, -1, -1> x(5, 2, 3);
+    stack(items, x.as_view());
+    for (int i = 0; i < 5; ++i)
+        CHECK(x[i] == items[i]);
+
+    auto y = stack<int, -1, 3>(items);
+    CHECK(y.shape().to_array() == std::array<dim_t, 3> { 5, 2, 3 });
+    CHECK(std::equal(x.data(), x.data() + x.size(), y.data()));
+
+    // Same result with several threads, including more threads than items
+    tensor<int, -1, 2, 3> z(5);
+    stack(items, z.as_view(), std::identity{}, 3);
+    CHECK(std::equal(x.data(), x.data() + x.size(), z.data()));
+    stack(items, z.as_view(), std::identity{}, 16);
+    CHECK(std::equal(x.data(), x.data() + x.size(), z.data()));
+
+    // Projection
+    std::vector<std::pair<int, tensor<int, -1, -1>>> pairs;
+    for (auto const& item : items)
+        pairs.emplace_back(0, item);
+    auto w = stack<int, -1, -1>(pairs, &std::pair<int, tensor<int, -1, -1>>::second);
+    CHECK(std::equal(x.data(), x.data() + x.size(), w.data()));
+
+    // Empty batches keep known dimensions
+    std::vector<tensor<int, -1, -1>> none;
+    CHECK(stack<int, -1, 3>(none).shape().to_array() == std::array<dim_t, 3> { 0, 0, 3 });
+
+    // Mismatching shapes are rejected
+    CHECK_THROWS_AS(stack(items, tensor<int, -1, -1, -1>(4, 2, 3).as_view()), shape_error);
+    CHECK_THROWS_AS(stack(items, tensor<int, -1, -1, -1>(5, 3, 2).as_view()), shape_error);
+    items[2] = tensor<int, -1, -1>(3, 2);
+    CHECK_THROWS_AS((stack<int, -1, -1>(items)), shape_error);
+}
+
+
 TEST_CASE("JSON") {
 
     nlohmann::json j;
@@ -0,0 +1,44 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <stdexcept>
+
+#include "game/connect.hpp"
+#include "game/tensor.hpp"
+
+
+using namespace game;
+
+
+TEST_CASE("Checked access") {
+
+    tensor<int, 2, 3> x;
+    tensor<int, -1, -1> y(2, 3);
+    tensor<int, -1> z(3);
+
+    CHECK_NOTHROW(x[1][2]);
+    CHECK_NOTHROW(y[1][2]);
+    CHECK_NOTHROW(y(1, 2));
+
+    CHECK_THROWS_AS(x[2], std::out_of_range);
+    CHECK_THROWS_AS(x[0][3], std::out_of_range);
+    CHECK_THROWS_AS(x(0, -1), std::out_of_range);
+    CHECK_THROWS_AS(y[2], std::out_of_range);
+    CHECK_THROWS_AS(y[1][3], std::out_of_range);
+    CHECK_THROWS_AS(y(-1, 0), std::out_of_range);
+    CHECK_THROWS_AS(z[3], std::out_of_range);
+    CHECK_THROWS_AS(y.as_view()[5], std::out_of_range);
+}
+
+
+TEST_CASE("Checked playthrough") {
+
+    // Game logic must stay within bounds
+    auto config = std::make_shared<connect::Config>(4, 5, 3);
+    auto state = config->sample_initial_state();
+    for (int i = 0; !state->has_ended(); ++i) {
+        auto actions = state->get_actions();
+        state = actions[i % actions.size()]->sample_next_state();
+    }
+    CHECK(state->has_ended());
+}
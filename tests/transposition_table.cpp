@@ -0,0 +1,146 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "game/connect.hpp"
+#include "game/transposition_table.hpp"
+
+
+using namespace game;
+
+
+struct Payload {
+    int16_t depth;
+    int16_t flags;
+    int32_t score;
+};
+
+// Larger than a word, to exercise verification across several words
+struct Wide {
+    uint64_t a;
+    uint64_t b;
+    uint64_t c;
+    int64_t depth;
+};
+
+
+// Verification is probabilistic, hence payloads must look random with respect to keys
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+
+TEST_CASE("Layout") {
+
+    using Table = transposition_table<Payload>;
+    CHECK(Table::entries_per_bucket == 4);
+
+    Table table(1000);
+    CHECK(table.capacity() == 1024);
+    CHECK(table.get_memory_usage() == 256 * 64);
+
+    using WideTable = transposition_table<Wide>;
+    CHECK(WideTable::entries_per_bucket == 1);
+    CHECK(WideTable(3).capacity() == 4);
+}
+
+
+TEST_CASE("Insert and find") {
+
+    transposition_table<Payload> table(64);
+
+    CHECK(!table.find_hash(42));
+    table.insert_hash(42, { 3, 0, 100 });
+    REQUIRE(table.find_hash(42));
+    CHECK(table.find_hash(42)->score == 100);
+    CHECK(!table.find_hash(43));
+
+    // Zero is a valid hash
+    table.insert_hash(0, { 1, 0, 7 });
+    CHECK(table.find_hash(0)->score == 7);
+
+    // Shallower results do not replace deeper ones
+    table.insert_hash(42, { 2, 0, 200 });
+    CHECK(table.find_hash(42)->score == 100);
+    table.insert_hash(42, { 3, 0, 300 });
+    CHECK(table.find_hash(42)->score == 300);
+
+    // Keys are game hashes
+    auto config = std::make_shared<connect::Config>(6, 7, 4);
+    auto state = config->sample_initial_state();
+    table.insert(*state, { 5, 1, -1 });
+    CHECK(table.find(*state)->flags == 1);
+    CHECK(table.find_hash(hash_value(*state))->depth == 5);
+    CHECK(!table.find(*state->get_action_at(0)->sample_next_state()));
+
+    table.clear();
+    CHECK(!table.find_hash(42));
+    CHECK(!table.find(*state));
+}
+
+
+TEST_CASE("Replacement") {
+
+    // Single bucket, with four entries
+    transposition_table<Payload> deep(4);
+    for (int i = 0; i < 4; ++i)
+        deep.insert_hash((i + 1) << 8, { int16_t(10 + i), 0, i });
+
+    // The shallowest entry is evicted, even by a shallower one
+    deep.insert_hash(5 << 8, { 1, 0, 4 });
+    CHECK(!deep.find_hash(1 << 8));
+    CHECK(deep.find_hash(2 << 8));
+    CHECK(deep.find_hash(5 << 8));
+    deep.insert_hash(6 << 8, { 20, 0, 5 });
+    CHECK(!deep.find_hash(5 << 8));
+    CHECK(deep.find_hash(6 << 8));
+
+    // Same key, without depth
+    transposition_table<int64_t, replacement::always> always(4);
+    always.insert_hash(1, 10);
+    always.insert_hash(1, 20);
+    CHECK(*always.find_hash(1) == 20);
+    for (int i = 2; i < 10; ++i)
+        always.insert_hash(i, i);
+    CHECK(*always.find_hash(9) == 9);
+}
+
+
+TEST_CASE("Concurrent access") {
+
+    // Each payload is derived from its key, so that torn entries would be noticed
+    transposition_table<Wide, replacement::always> table(256);
+    std::atomic<int> errors = 0;
+    std::atomic<int> hits = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            uint64_t x = t + 1;
+            for (int i = 0; i < 100000; ++i) {
+                x = x * 6364136223846793005ull + 1442695040888963407ull;
+                uint64_t key = mix(x >> 52);
+                if (i % 2) {
+                    table.insert_hash(key, { mix(key), mix(key + 1), mix(key + 2), int64_t(i) });
+                }
+                else if (auto payload = table.find_hash(key)) {
+                    ++hits;
+                    if (payload->a != mix(key) || payload->b != mix(key + 1) || payload->c != mix(key + 2))
+                        ++errors;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(errors == 0);
+    CHECK(hits > 0);
+}